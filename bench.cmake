@@ -0,0 +1,152 @@
+# Memory mapped file io test. (C) IC Book Labs.
+# Smoke benchmark matrix: sizes x patterns x engines, one batch run of mapfile per cell,
+# results of all cells merged to one JSON file. Run by "bench" build target, or directly:
+# cmake -DMAPFILE=<mapfile binary> -DSIZES=16M,64M -DPATTERNS=passes,seq,random
+#       -DENGINES=file,tmpfs,memfd,anon -DREPEATS=3 -DLOCAL_DIR=<dir> -DTMPFS_DIR=<dir>
+#       -DOUTPUT=<json file> [-DBASELINE=<baseline file> -DTOLERANCE=50 -DUPDATE=ON] -P bench.cmake
+# Any failed cell stops the matrix with error, so regressions in the tool itself fail the run.
+# Write and read MBPS of each cell checked by sanity bounds of its engine. Passes cells, medians
+# over repeats, also checked by baseline if set: run fails if median below baseline by more than
+# TOLERANCE percent. Scenario cells are single runs, too noisy for baseline. UPDATE=ON rewrites baseline.
+
+cmake_minimum_required(VERSION 3.10)
+
+foreach(parm MAPFILE SIZES PATTERNS ENGINES REPEATS LOCAL_DIR TMPFS_DIR OUTPUT)
+    if(NOT DEFINED ${parm})
+        message(FATAL_ERROR "bench.cmake: ${parm} not defined")
+    endif()
+endforeach()
+if(NOT DEFINED TOLERANCE)
+    set(TOLERANCE 50)
+endif()
+if(UPDATE AND NOT BASELINE)
+    message(FATAL_ERROR "bench.cmake: UPDATE requires BASELINE file")
+endif()
+
+#--- Sanity bounds per engine, MBPS: write minimum and maximum, read minimum and maximum ---
+# Value out of bounds means broken timing or broken phase, for example in-memory fill
+# reported above memory bandwidth, or durable file write faster than any storage device.
+set(BOUNDS_file  1 100000 1 2000000)
+set(BOUNDS_pmem  1 100000 1 2000000)
+set(BOUNDS_tmpfs 1 500000 1 2000000)
+set(BOUNDS_memfd 1 500000 1 2000000)
+set(BOUNDS_anon  1 500000 1 2000000)
+
+#--- Baseline: lines "<cell> <write|read> <MBPS>", cell is size-passes-engine ---
+set(baseline "")
+if(BASELINE AND NOT UPDATE)
+    if(NOT EXISTS "${BASELINE}")
+        message(FATAL_ERROR "bench.cmake: baseline ${BASELINE} not found")
+    endif()
+    file(STRINGS "${BASELINE}" baseline REGEX "^[^#]")
+endif()
+set(records "")
+set(failures "")
+
+string(REPLACE "," ";" SIZES "${SIZES}")
+string(REPLACE "," ";" PATTERNS "${PATTERNS}")
+string(REPLACE "," ";" ENGINES "${ENGINES}")
+file(MAKE_DIRECTORY "${LOCAL_DIR}")
+
+set(cells "")
+foreach(size IN LISTS SIZES)
+    foreach(pattern IN LISTS PATTERNS)
+        foreach(engine IN LISTS ENGINES)
+            set(name "${size}-${pattern}-${engine}")
+            set(json "${LOCAL_DIR}/${name}.json")
+            #--- Mapped file location, not used by memfd and anon engines ---
+            if(engine STREQUAL "tmpfs")
+                set(path "${TMPFS_DIR}/mapfile-bench.bin")
+            else()
+                set(path "${LOCAL_DIR}/mapfile-bench.bin")
+            endif()
+            set(args path=${path} size=${size} target=${engine} wdelay=0 rdelay=0 batch=on json=${json})
+            #--- Passes, or scenario with read and write walks by pattern ---
+            if(pattern STREQUAL "passes")
+                list(APPEND args repeats=${REPEATS})
+            else()
+                set(scenario "${LOCAL_DIR}/${name}.txt")
+                file(WRITE "${scenario}"
+                     "# Smoke benchmark cell ${name}\n"
+                     "create    size=${size}\n"
+                     "read      threads=1 pattern=${pattern}\n"
+                     "write     threads=1 pattern=${pattern}\n"
+                     "flush     threads=1\n"
+                     "delete\n")
+                list(APPEND args scenario=${scenario})
+            endif()
+            file(REMOVE "${json}")
+            execute_process(COMMAND "${MAPFILE}" ${args}
+                            RESULT_VARIABLE result
+                            OUTPUT_VARIABLE output
+                            ERROR_VARIABLE output)
+            if(NOT result EQUAL 0)
+                message(FATAL_ERROR "bench ${name}: mapfile exit code ${result}\n${output}")
+            endif()
+            file(READ "${json}" cell)
+            string(STRIP "${cell}" cell)
+            #--- Write and read MBPS: phase medians for passes, phase MBPS for scenario ---
+            if(pattern STREQUAL "passes")
+                string(REGEX MATCHALL "\"name\": \"(write|read)\", \"median\": [0-9.]+" metrics "${cell}")
+            else()
+                string(REGEX MATCHALL "\"type\": \"(write|read)\", [^}]*\"mbps\": [0-9.]+" metrics "${cell}")
+            endif()
+            if(NOT metrics)
+                list(APPEND failures "${name}: no write and read results")
+            endif()
+            if(NOT DEFINED BOUNDS_${engine})
+                message(WARNING "bench ${name}: no sanity bounds for engine ${engine}")
+            endif()
+            foreach(metric IN LISTS metrics)
+                string(REGEX REPLACE "^\"[a-z]+\": \"([a-z]+)\".* ([0-9.]+)$" "\\1;\\2" metric "${metric}")
+                list(GET metric 0 kind)
+                list(GET metric 1 mbps)
+                if(pattern STREQUAL "passes")
+                    list(APPEND records "${name} ${kind} ${mbps}")
+                endif()
+                if(DEFINED BOUNDS_${engine})
+                    if(kind STREQUAL "write")
+                        list(GET BOUNDS_${engine} 0 low)
+                        list(GET BOUNDS_${engine} 1 high)
+                    else()
+                        list(GET BOUNDS_${engine} 2 low)
+                        list(GET BOUNDS_${engine} 3 high)
+                    endif()
+                    if((mbps LESS low) OR (mbps GREATER high))
+                        list(APPEND failures "${name} ${kind}: ${mbps} MBPS out of sanity bounds ${low}...${high}")
+                    endif()
+                endif()
+                if(NOT pattern STREQUAL "passes")
+                    continue()
+                endif()
+                foreach(line IN LISTS baseline)
+                    if(line MATCHES "^${name} ${kind} ([0-9.]+)")
+                        string(REGEX REPLACE "\\..*$" "" reference "${CMAKE_MATCH_1}")
+                        math(EXPR threshold "${reference} * (100 - ${TOLERANCE}) / 100")
+                        if(mbps LESS threshold)
+                            list(APPEND failures "${name} ${kind}: ${mbps} MBPS below baseline ${reference} by more than ${TOLERANCE}%")
+                        endif()
+                    endif()
+                endforeach()
+            endforeach()
+            if(cells)
+                string(APPEND cells ",\n")
+            endif()
+            string(APPEND cells "{ \"size\": \"${size}\", \"pattern\": \"${pattern}\", \"engine\": \"${engine}\",\n  \"result\": ${cell} }")
+            message(STATUS "bench ${name}: done")
+        endforeach()
+    endforeach()
+endforeach()
+
+file(WRITE "${OUTPUT}" "{ \"bench\": [\n${cells}\n] }\n")
+message(STATUS "bench results: ${OUTPUT}")
+
+if(BASELINE AND UPDATE)
+    string(REPLACE ";" "\n" records "${records}")
+    file(WRITE "${BASELINE}" "# Smoke benchmark baseline, MBPS: <cell> <write|read> <MBPS>, written by bench with UPDATE=ON\n${records}\n")
+    message(STATUS "bench baseline updated: ${BASELINE}")
+endif()
+if(failures)
+    string(REPLACE ";" "\n" failures "${failures}")
+    message(FATAL_ERROR "bench regressions:\n${failures}")
+endif()
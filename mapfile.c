@@ -2,6 +2,7 @@
 Memory mapped file io test. (C) IC Book Labs.
 IPB/TPB/OPB communication sample.
 See some details at: tmp1_linuxport.TXT , tmp2_fordisks.TXT.
+Console shell for benchmark library, see mmb.h.
 */
 
 #define _GNU_SOURCE
@@ -18,95 +19,47 @@ See some details at: tmp1_linuxport.TXT , tmp2_fordisks.TXT.
 #include <fcntl.h>
 #include <sys/stat.h>
 #include <sys/types.h>
-#include <windows.h>
+#include <math.h>
+#include "mmb.h"
 
 //--- Title string ---
-#if _WIN64
+#if defined(_WIN32) && MMB_64BIT
 #define TITLE "Memory-mapped files benchmark for Windows 64.\n(C)2018 IC Book Labs. v0.06"
-#else
+#elif defined(_WIN32)
 #define TITLE "Memory-mapped files benchmark for Windows 32.\n(C)2018 IC Book Labs. v0.06"
+#else
+#define TITLE "Memory-mapped files benchmark for Linux.\n(C)2018 IC Book Labs. v0.06"
 #endif
 
-//--- Defaults definitions ---
-#define FILE_PATH   "myfile.bin"       // default file path and name
-#define FILE_SIZE   1024*1024*1024     // default file size, bytes
-#define WRITE_DELAY 100                // default delay from Start to Write in milliseconds, argument of Sleep()
-#define READ_DELAY  100                // default delay from Write end to Read in milliseconds, argument of Sleep()
-#define MEASURE_REPEATS 5              // default number of measurement repeats
-
-//--- Limits definitions ---
-#define FILE_SIZE_MIN  4096            // minimum file size 4096 bytes
-#define FILE_SIZE_MAX  1536*1024*1024  // maximum file size 1.5 gigabytes
-#define DELAY_MIN      0               // minimum delay value, 0 milliseconds
-#define DELAY_MAX      100000          // maximum delay value, 100000 milliseconds = 100 seconds
-#define REPEATS_MIN    0               // minimum number of measurement repeats
-#define REPEATS_MAX    100             // maximum number of measurement repeats
-
-//--- Timer constant ---
-#define TIME_TO_SECONDS 0.0000001    // multiply by this to convert 100 nanosecond units to seconds
-
-//--- Page walk constant ---
-// #define PAGE_WALK_STEP 512        // step for cause swapping, page=4096 bytes but sector=512 bytes, make safe, actual only for READ
-#define PAGE_WALK_STEP 4096
-
 //--- Output tabulation options ---
 #define IPB_TABS  18    // number of chars before "=" for tabulation, this used for start conditions (input parameters block)
 #define OPB_TABS  8     // number of chars before "=" for tabulation, this used for results statistics (output/transit parm. block)
 
-//--- Numeric data for storing command line options, with defaults assigned ---
-static char    fileDefaultPath[] = FILE_PATH;   // constant string for references
-static char*   filePath   = fileDefaultPath;    // pointer to file path string
-static size_t  fileSize   = FILE_SIZE;          // file size, bytes
-static int     writeDelay = WRITE_DELAY;        // delay from start to write, milliseconds
-static int     readDelay  = READ_DELAY;         // delay from write end to read, milliseconds
-static int     repeats = MEASURE_REPEATS;       // number of times to repeat test, for measurement precision
-
-//--- File creation variables, parameters of CreateFile funcion  ---
-static HANDLE fileHandle = NULL;                                                // file handle, result of CreateFile
-static DWORD  fileAccess = GENERIC_READ | GENERIC_WRITE;                        // file access mode
-static DWORD  fileShare  = NULL;                                                // file share mode, not used
-static LPSECURITY_ATTRIBUTES fileSecurity = NULL;                               // security mode, not used
-static DWORD fileCreate = CREATE_ALWAYS;                                        // file create mode, at start before write
-static DWORD fileFlags  = FILE_ATTRIBUTE_NORMAL | FILE_FLAG_WRITE_THROUGH |
-                          FILE_FLAG_NO_BUFFERING | FILE_FLAG_SEQUENTIAL_SCAN;   // file attributes, no buferring, write through
-static HANDLE* fileTemplate = NULL;                                             // file template, not used
-//--- File re-open variables changes ---
-static DWORD fileOpen = OPEN_ALWAYS;                                            // file open mode, after write before read
-
-//--- Mapping creation variables, parameters of CreateFileMapping function ---
-static HANDLE mapHandle = NULL;                  // mapping handle, result of CreateMapping
-static LPSECURITY_ATTRIBUTES mapSecurity = 0;    // mapping security mode, not used
-static DWORD mapProtect = PAGE_READWRITE;        // mapping protection attributes
-static DWORD mapSizeHigh = 0;                    // high 32 bits of mapping size
-static DWORD mapSizeLow = 0;                     // low 32 bits of mapping size
-static LPCTSTR mapName = NULL;                   // mapping name, not used
-
-//--- Mapping address variables, parameters of MapViewOfFile function ---
-static LPVOID mapPointer = NULL;                 // virtual address of mapping view, result of MapViewOfFile
-static DWORD viewAccess = FILE_MAP_ALL_ACCESS;   // mapping view access mode
-static DWORD viewOffsetHigh = 0;                 // high 32 bits of mapping size
-static DWORD viewOffsetLow = 0;                  // low 32 bits of mapping size
-// static SIZE_T viewSize = 0;
-
-//--- Miscellaneous status ---
-int status = 0;                                  // status for return by API functions
+//--- Benchmark context, options updated by command line ---
+static MMB_CONTEXT context;
 
 //--- Numeric data for benchmarks results statistics ---
-static double readLog[REPEATS_MAX];    // array of read results, megabytes per second
-static double writeLog[REPEATS_MAX];   // array of write results, megabytes per second
-static int logCount = 0;               // number of actual log entries
-static double resultMedian = 0.0;      // median speed, megabytes per second
-static double resultAverage = 0.0;     // average speed, megabytes per second
-static double resultMinimum = 0.0;     // minimum detected speed, megabytes per second
-static double resultMaximum = 0.0;     // maximum detected speed, megabytes per second
-
-//--- Data for timings and benchmarks ---
-typedef union
-    {
-    FILETIME ft;           // return of GetSystemTimeAsFileTime
-    long long lt;          // access as 64-bit value
-    } UNITIME;
-static UNITIME ut1, ut2;    // results of GetSystemTimeAsFileTime, at start and stop of measured interval
+static MMB_STATS results;
+
+//--- Scenario: file path, phase parsed from current line, list of phases ---
+static char scenarioNone[] = "none";            // constant string for references, means no scenario
+static char* scenarioPath = scenarioNone;       // pointer to scenario file path string
+static MMB_PHASE scenarioEntry;                 // phase options updated by scenario line parse
+static MMB_PHASE scenario[MMB_SCENARIO_MAX];        // list of scenario phases
+static int scenarioCount = 0;                   // number of scenario phases
+
+//--- Trace: file path, loaded records ---
+static char traceNone[] = "none";               // constant string for references, means no trace replay
+static char* tracePath = traceNone;             // pointer to trace file path string
+static MMB_TRACE trace;                         // loaded trace
+static char hotsetNone[] = "none";              // constant string for references, means no hot set
+static char* hotsetPath = hotsetNone;           // pointer to hot set file path string
+static MMB_HOTSET hotset;                       // loaded hot set
+
+//--- Batch run: no start prompt, results optionally saved to JSON file ---
+static int batchMode = 0;                       // 1 means start without Y/N prompt
+static char jsonNone[] = "none";                // constant string for references, means no JSON results file
+static char* jsonPath = jsonNone;               // pointer to JSON results file path string
 
 //--- Strings ---
 static char sPath[]     = "path"     ,  // this for command line options names detect
@@ -114,21 +67,118 @@ static char sPath[]     = "path"     ,  // this for command line options names d
             sWdelay[]   = "wdelay"   ,
             sRdelay[]   = "rdelay"   ,
             sRepeats[]  = "repeats"  ,
+            sAlloc[]    = "alloc"    ,
+            sPunch[]    = "punch"    ,
+            sReuse[]    = "reuse"    ,
+            sMapping[]  = "mapping"  ,
+            sTarget[]   = "target"   ,
+            sScenario[] = "scenario" ,
+            sTrace[]    = "trace"    ,
+            sReplay[]   = "replay"   ,
+            sCounters[] = "counters" ,
+            sFlush[]    = "flush"    ,
+            sChunk[]    = "chunk"    ,
+            sPressure[] = "pressure" ,
+            sCgroup[]   = "cgroup"   ,
+            sRate[]     = "rate"     ,
+            sSweep[]    = "sweep"    ,
+            sMode[]     = "mode"     ,
+            sFirst[]    = "first"    ,
+            sCache[]    = "cache"    ,
+            sHotset[]   = "hotset"   ,
+            sBatch[]    = "batch"    ,
+            sJson[]     = "json"     ,
+            sStep[]     = "step"     ,
+            sOffset[]   = "offset"   ,
+            sAlign[]    = "align"    ,
+            sStraddle[] = "straddle" ,
+            sTouch[]    = "touch"    ,
+            
+            sPhSize[]       = "size"       ,    // this for scenario phase options names detect
+            sPhAlloc[]      = "alloc"      ,
+            sPhAdvice[]     = "advice"     ,
+            sPhThreads[]    = "threads"    ,
+            sPhPattern[]    = "pattern"    ,
+            sPhDuration[]   = "duration"   ,
+            sPhInterval[]   = "interval"   ,
+            sPhBackground[] = "background" ,
             
             ssPath[]    = "file path"         ,    // this for start conditions visual
             ssSize[]    = "file size"         ,
             ssWdelay[]  = "write delay (ms)"  ,
             ssRdelay[]  = "read delay (ms)"   ,
             ssRepeats[] = "repeat times"      ,
+            ssAlloc[]   = "allocation mode"   ,
+            ssPunch[]   = "punch-hole phase"  ,
+            ssReuse[]   = "file reuse mode"   ,
+            ssMapping[] = "mapping mode"      ,
+            ssTarget[]  = "mapping target"    ,
+            ssScenario[] = "scenario file"    ,
+            ssTrace[]   = "trace file"        ,
+            ssReplay[]  = "trace replay mode" ,
+            ssCounters[] = "perf. counters"   ,
+            ssFlush[]   = "flush mode"        ,
+            ssChunk[]   = "flush chunk"       ,
+            ssPressure[] = "pressure balloon" ,
+            ssCgroup[]  = "memory limit"      ,
+            ssRate[]    = "read rate (pg/s)"  ,
+            ssSweep[]   = "sweep"             ,
+            ssMode[]    = "file mode"         ,
+            ssFirst[]   = "first pages"       ,
+            ssCache[]   = "file cache"        ,
+            ssHotset[]  = "hot set file"      ,
+            ssBatch[]   = "batch mode"        ,
+            ssJson[]    = "JSON results file" ,
+            ssStep[]    = "page walk step"    ,
+            ssOffset[]  = "view offset"       ,
+            ssAlign[]   = "walk align"        ,
+            ssStraddle[] = "straddle phase"   ,
+            ssTouch[]   = "shared write-touch",
+            ssPage[]    = "page size"         ,
+            ssGranule[] = "view granularity"  ,
             
             sMedian[]   = "Median"   ,             // this for result statistics median
             sAverage[]  = "Average"  ,
             sMinimum[]  = "Minimum"  ,
             sMaximum[]  = "Maximum"  ;
 
+//--- Titles for result statistics, per measured phase ---
+static char* statTitles[] =
+    {
+    "Write statistics (MBPS):",
+    "Read statistics (MBPS):",
+    "Write-touch statistics (MBPS):",
+    "Write-touch median fault latency statistics (microseconds):",
+    "Refault into holes statistics (MBPS):",
+    "Trace replay statistics (MBPS):",
+    "Trace replay median access latency statistics (microseconds):",
+    "Trace replay 99th percentile access latency statistics (microseconds):",
+    "Read page faults per page statistics (refault rate):",
+    "Rate-limited read median touch latency statistics (microseconds):",
+    "Rate-limited read 99th percentile touch latency statistics (microseconds):",
+    "Startup open file statistics (microseconds):",
+    "Startup create mapping statistics (microseconds):",
+    "Startup map view statistics (microseconds):",
+    "Startup touch first pages statistics (microseconds):",
+    "Startup total, open up to first pages touched, statistics (microseconds):",
+    "Startup touch hot set statistics (microseconds):",
+    "Page aligned cold probe latency statistics (microseconds):",
+    "Page-straddling cold probe latency statistics (microseconds):",
+    "Rate-limited read achieved rate statistics (pages per second):",
+    "Page aligned cold probe page faults per probe statistics:",
+    "Page-straddling cold probe page faults per probe statistics:"
+    };
+
+//--- Names for scenario options selected from text strings ---
+static char* backgroundNames[] = { "off", "on" };
+
+//--- Names for batch option ---
+static char* batchNames[] = { "off", "on" };
+
 //--- Control block for command line parse, build IPB = Input Parameters Block ---
+// Same control block used for scenario file lines parse, build SPB = Scenario Parameters Block.
 typedef enum
-    { NOOPT, INTPARM, MEMPARM, SELPARM, STRPARM } OPTION_TYPES;
+    { NOOPT, INTPARM, MEMPARM, SELPARM, STRPARM, TIMEPARM } OPTION_TYPES;
 typedef struct
     {
     char* name;             // pointer to parm. name for recognition NAME=VALUE
@@ -141,14 +191,54 @@ typedef struct
 //--- Entries for command line options, null-terminated list ---
 static OPTION_ENTRY ipb_list[] =
     {
-        { sPath    ,  NULL ,  0 ,  &filePath   ,  STRPARM },
-		{ sSize    ,  NULL ,  0 ,  &fileSize   ,  MEMPARM },
-		{ sWdelay  ,  NULL ,  0 ,  &writeDelay ,  INTPARM },
-        { sRdelay  ,  NULL ,  0 ,  &readDelay  ,  INTPARM },
-        { sRepeats ,  NULL ,  0 ,  &repeats    ,  INTPARM },
+        { sPath    ,  NULL ,  0 ,  &context.filePath   ,  STRPARM },
+		{ sSize    ,  NULL ,  0 ,  &context.fileSize   ,  MEMPARM },
+		{ sWdelay  ,  NULL ,  0 ,  &context.writeDelay ,  INTPARM },
+        { sRdelay  ,  NULL ,  0 ,  &context.readDelay  ,  INTPARM },
+        { sRepeats ,  NULL ,  0 ,  &context.repeats    ,  INTPARM },
+        { sAlloc   ,  mmbAllocNames   ,  4 ,  &context.allocMode   ,  SELPARM },
+        { sPunch   ,  mmbPunchNames   ,  2 ,  &context.punchMode   ,  SELPARM },
+        { sReuse   ,  mmbReuseNames   ,  3 ,  &context.reuseMode   ,  SELPARM },
+        { sMapping ,  mmbMappingNames ,  3 ,  &context.mappingMode ,  SELPARM },
+        { sTarget  ,  mmbTargetNames  ,  5 ,  &context.targetMode  ,  SELPARM },
+        { sScenario,  NULL ,  0 ,  &scenarioPath       ,  STRPARM },
+        { sTrace   ,  NULL ,  0 ,  &tracePath          ,  STRPARM },
+        { sReplay  ,  mmbReplayNames  ,  2 ,  &context.replayMode  ,  SELPARM },
+        { sCounters,  mmbCountersNames,  2 ,  &context.countersMode,  SELPARM },
+        { sFlush   ,  mmbFlushNames   ,  3 ,  &context.flushMode   ,  SELPARM },
+        { sChunk   ,  NULL ,  0 ,  &context.flushChunk ,  MEMPARM },
+        { sPressure,  NULL ,  0 ,  &context.pressureSize,  MEMPARM },
+        { sCgroup  ,  NULL ,  0 ,  &context.memoryLimit ,  MEMPARM },
+        { sRate    ,  NULL ,  0 ,  &context.touchRate  ,  INTPARM },
+        { sSweep   ,  mmbSweepNames   ,  3 ,  &context.sweepMode   ,  SELPARM },
+        { sMode    ,  mmbModeNames    ,  2 ,  &context.fileMode    ,  SELPARM },
+        { sFirst   ,  NULL ,  0 ,  &context.firstPages ,  INTPARM },
+        { sCache   ,  mmbCacheNames   ,  2 ,  &context.cacheMode   ,  SELPARM },
+        { sHotset  ,  NULL ,  0 ,  &hotsetPath         ,  STRPARM },
+        { sBatch   ,  batchNames      ,  2 ,  &batchMode           ,  SELPARM },
+        { sJson    ,  NULL ,  0 ,  &jsonPath           ,  STRPARM },
+        { sStep    ,  NULL ,  0 ,  &context.walkStep   ,  MEMPARM },
+        { sOffset  ,  NULL ,  0 ,  &context.viewOffset ,  MEMPARM },
+        { sAlign   ,  NULL ,  0 ,  &context.viewAlign  ,  MEMPARM },
+        { sStraddle,  mmbStraddleNames,  2 ,  &context.straddleMode,  SELPARM },
+        { sTouch   ,  mmbTouchNames   ,  2 ,  &context.touchMode   ,  SELPARM },
         { NULL     ,  NULL ,  0 ,  NULL        ,  NOOPT   }
     };
 
+//--- Entries for scenario phase options, null-terminated list ---
+static OPTION_ENTRY spb_list[] =
+    {
+        { sPhSize       ,  NULL            ,  0 ,  &scenarioEntry.size       ,  MEMPARM  },
+        { sPhAlloc      ,  mmbAllocNames   ,  4 ,  &scenarioEntry.alloc      ,  SELPARM  },
+        { sPhAdvice     ,  mmbAdviceNames  ,  2 ,  &scenarioEntry.advice     ,  SELPARM  },
+        { sPhThreads    ,  NULL            ,  0 ,  &scenarioEntry.threads    ,  INTPARM  },
+        { sPhPattern    ,  mmbPatternNames ,  2 ,  &scenarioEntry.pattern    ,  SELPARM  },
+        { sPhDuration   ,  NULL            ,  0 ,  &scenarioEntry.duration   ,  TIMEPARM },
+        { sPhInterval   ,  NULL            ,  0 ,  &scenarioEntry.interval   ,  TIMEPARM },
+        { sPhBackground ,  backgroundNames ,  2 ,  &scenarioEntry.background ,  SELPARM  },
+        { NULL          ,  NULL            ,  0 ,  NULL                      ,  NOOPT    }
+    };
+
 //--- Control block for start conditions parameters visual, bulid TPB = Transit Parameters Block ---
 typedef enum
     { NOPRN, VDOUBLE, VINTEGER, MEMSIZE, SELECTOR, POINTER, HEX64, MHZ, STRNG } PRINT_TYPES;
@@ -163,11 +253,39 @@ typedef struct
 //--- Entries for print, null-terminated list ---
 static PRINT_ENTRY tpb_list[] = 
     {
-    	{ ssPath    ,  NULL ,  &filePath   ,  STRNG    },
-		{ ssSize    ,  NULL ,  &fileSize   ,  MEMSIZE  },
-		{ ssWdelay  ,  NULL ,  &writeDelay ,  VINTEGER },
-        { ssRdelay  ,  NULL ,  &readDelay  ,  VINTEGER },
-        { ssRepeats ,  NULL ,  &repeats    ,  VINTEGER },
+    	{ ssPath    ,  NULL ,  &context.filePath   ,  STRNG    },
+		{ ssSize    ,  NULL ,  &context.fileSize   ,  MEMSIZE  },
+		{ ssWdelay  ,  NULL ,  &context.writeDelay ,  VINTEGER },
+        { ssRdelay  ,  NULL ,  &context.readDelay  ,  VINTEGER },
+        { ssRepeats ,  NULL ,  &context.repeats    ,  VINTEGER },
+        { ssAlloc   ,  mmbAllocNames   ,  &context.allocMode   ,  SELECTOR },
+        { ssPunch   ,  mmbPunchNames   ,  &context.punchMode   ,  SELECTOR },
+        { ssReuse   ,  mmbReuseNames   ,  &context.reuseMode   ,  SELECTOR },
+        { ssMapping ,  mmbMappingNames ,  &context.mappingMode ,  SELECTOR },
+        { ssTarget  ,  mmbTargetNames  ,  &context.targetMode  ,  SELECTOR },
+        { ssScenario,  NULL ,  &scenarioPath       ,  STRNG    },
+        { ssTrace   ,  NULL ,  &tracePath          ,  STRNG    },
+        { ssReplay  ,  mmbReplayNames  ,  &context.replayMode  ,  SELECTOR },
+        { ssCounters,  mmbCountersNames,  &context.countersMode,  SELECTOR },
+        { ssFlush   ,  mmbFlushNames   ,  &context.flushMode   ,  SELECTOR },
+        { ssChunk   ,  NULL ,  &context.flushChunk ,  MEMSIZE  },
+        { ssPressure,  NULL ,  &context.pressureSize,  MEMSIZE  },
+        { ssCgroup  ,  NULL ,  &context.memoryLimit ,  MEMSIZE  },
+        { ssRate    ,  NULL ,  &context.touchRate  ,  VINTEGER },
+        { ssSweep   ,  mmbSweepNames   ,  &context.sweepMode   ,  SELECTOR },
+        { ssMode    ,  mmbModeNames    ,  &context.fileMode    ,  SELECTOR },
+        { ssFirst   ,  NULL ,  &context.firstPages ,  VINTEGER },
+        { ssCache   ,  mmbCacheNames   ,  &context.cacheMode   ,  SELECTOR },
+        { ssHotset  ,  NULL ,  &hotsetPath         ,  STRNG    },
+        { ssBatch   ,  batchNames      ,  &batchMode           ,  SELECTOR },
+        { ssJson    ,  NULL ,  &jsonPath           ,  STRNG    },
+        { ssStep    ,  NULL ,  &context.walkStep   ,  MEMSIZE  },
+        { ssOffset  ,  NULL ,  &context.viewOffset ,  MEMSIZE  },
+        { ssAlign   ,  NULL ,  &context.viewAlign  ,  MEMSIZE  },
+        { ssStraddle,  mmbStraddleNames,  &context.straddleMode,  SELECTOR },
+        { ssTouch   ,  mmbTouchNames   ,  &context.touchMode   ,  SELECTOR },
+        { ssPage    ,  NULL ,  &context.pageSize   ,  MEMSIZE  },
+        { ssGranule ,  NULL ,  &context.granularity,  MEMSIZE  },
         { NULL      ,  NULL ,  0           ,  NOPRN    }
     }; 
 
@@ -175,68 +293,20 @@ static PRINT_ENTRY tpb_list[] =
 //--- Entries for print, null-terminated list ---
 static PRINT_ENTRY opb_list[] = 
     {
-        { sMedian     , NULL    , &resultMedian     , VDOUBLE  },
-        { sAverage    , NULL    , &resultAverage    , VDOUBLE  },
-        { sMinimum    , NULL    , &resultMinimum    , VDOUBLE  },
-        { sMaximum    , NULL    , &resultMaximum    , VDOUBLE  },
+        { sMedian     , NULL    , &results.median   , VDOUBLE  },
+        { sAverage    , NULL    , &results.average  , VDOUBLE  },
+        { sMinimum    , NULL    , &results.minimum  , VDOUBLE  },
+        { sMaximum    , NULL    , &results.maximum  , VDOUBLE  },
         { NULL        , NULL    , 0                 , NOPRN    }
     };
 
-//--- Conditional methods definition for 32 and 64-bit platforms ---
-#if _WIN64
-convert64( size_t value64, DWORD *low32, DWORD *high32 )
-	{
-	*low32 = value64 & 0xFFFFFFFFLL;
-	*high32 = value64 >> 32;
-	}
-#else
-convert64( size_t value64, DWORD *low32, DWORD *high32 )
-	{
-	*low32 = value64;
-	*high32 = 0;
-	}
-#endif
-
-//--- Helper method for print memory size: bytes/KB/MB/GB, to scratch string ---
-// INPUT:   scratchPointer = pointer to destination string
-//          memsize = memory size for visual, bytes
+//--- Helper method for print memory size: bytes/KB/MB/GB, to console ---
+// INPUT:   memsize = memory size for visual, bytes
 // OUTPUT:  number of chars write
 //---
 #define KILO 1024
 #define MEGA 1024*1024
 #define GIGA 1024*1024*1024
-#define PRINT_LIMIT 20
-int scratchMemorySize( char* scratchPointer, size_t memsize )
-    {
-    double xd = memsize;
-    int nchars = 0;
-    if ( memsize < KILO )
-        {
-        int xi = memsize;
-        nchars = snprintf( scratchPointer, PRINT_LIMIT, "%d bytes", xi );
-        }
-    else if ( memsize < MEGA )
-        {
-        xd /= KILO;
-        nchars = snprintf( scratchPointer, PRINT_LIMIT, "%.2lfK", xd );
-        }
-    else if ( memsize < GIGA )
-        {
-        xd /= MEGA;
-        nchars = snprintf( scratchPointer, PRINT_LIMIT, "%.2lfM", xd );
-        }
-    else
-        {
-        xd /= GIGA;
-        nchars = snprintf( scratchPointer, PRINT_LIMIT, "%.2lfG", xd );
-        }
-    return nchars;
-    }
-
-//--- Helper method for print memory size: bytes/KB/MB/GB, to console ---
-// INPUT:   memsize = memory size for visual, bytes
-// OUTPUT:  number of chars write
-//---
 int printMemorySize( size_t memsize )
     {
     double xd = memsize;
@@ -273,58 +343,6 @@ void printSelectedString( int select, char* names[] )
     printf( "%s", names[select] );
     }
 
-//--- Helper method for calculate median, average, minimum, maximum ---
-// INPUT:   statArray[] = array of results
-//          statCount = number of actual results in the array, can be smaller than array size
-// OUTPUT:  update variables by input pointers:
-//          statMedian, statAverage, statMin, statMax
-//---
-void calculateStatistics( double statArray[], int statCount,
-                          double *statMedian, double *statAverage,
-                          double *statMin, double *statMax )
-    {
-    double statSum = 0.0;
-    double statTemp = 0.0;
-    int flag = 0;
-    int i = 0;
-    //--- Minimum, Maximum, Average ---
-    *statMin = statArray[0];
-    *statMax = statArray[0];
-    for ( i=0; i<statCount; i++ )
-        {
-        if ( *statMin > statArray[i] ) { *statMin = statArray[i]; }
-        if ( *statMax < statArray[i] ) { *statMax = statArray[i]; }
-        statSum += statArray[i];
-        }
-    *statAverage = statSum / statCount;
-    //--- Median, first ordering ---
-    flag = 1;
-    while ( flag == 1 )
-        {
-        flag = 0;
-        for ( i=0; i<(statCount-1); i++ )
-            {
-            if ( statArray[i] > statArray[i+1] )
-                {
-                statTemp = statArray[i];
-                statArray[i] = statArray[i+1];
-                statArray[i+1] = statTemp;
-                flag = 1;
-                }
-            }
-        }
-    if ( ( statCount % 2 ) == 0 )
-        {  // median if array length EVEN, average of middle pair
-        i = statCount / 2;
-        *statMedian = ( statArray[i-1] + statArray[i] ) / 2.0;
-        }
-    else
-        {  // median if array length ODD, middle element
-        i = statCount/2;
-        *statMedian = statArray[i];
-        }
-    }
-
 //--- Handler for Receive console input (command line, text file or GUI shell) data to IPB ---
 // IPB = Input Parameters Block
 // INPUT:   pCount = number of command line parameters 
@@ -508,6 +526,41 @@ DEBUG */
                     // fix bug with local variables destroyed
                     break;
                     }
+                case TIMEPARM:   // support time parameters, milliseconds, units ms/s/m
+                    {
+                    k1 = 1;
+                    k2 = strlen( pValue );
+                    if ( ( k2 > 2 ) && ( strcmp( pValue + k2 - 2, "ms" ) == 0 ) )
+                        {
+                        k2 -= 2;            // ms means milliseconds
+                        }
+                    else if ( pValue[k2-1] == 's' )
+                        {
+                        k2--;               // s means seconds
+                        k1 = 1000;
+                        }
+                    else if ( pValue[k2-1] == 'm' )
+                        {
+                        k2--;               // m means minutes
+                        k1 = 60000;
+                        }
+                    for ( k=0; k<k2; k++ )
+                        {
+                        if ( isdigit( pValue[k] ) == 0 )
+                            {
+                            k1 = 0;
+                            }
+                        }
+                    if ( ( k1==0 )||( k2==0 ) )
+                        {
+                        printf( "ERROR, NOT A TIME: %s\n", pValue );
+                        return 1;
+                        }
+                    k = atoi( pValue );   // convert string to integer, units skipped by atoi
+                    pInt = (int *) parse_control[j].data;
+                    *pInt = k * k1;
+                    break;
+                    }
                 }
             break;
             }
@@ -619,75 +672,374 @@ for ( i=0; print_control[i].name!=NULL; i++ )
     }
 }
 
+//--- Handler for Receive scenario file data to SPB ---
+// SPB = Scenario Parameters Block
+// Scenario file is text, one phase per line: phase type name, then NAME=VALUE options,
+// parsed by handlerInput() with scenario control array. Text after "#" is comment.
+// Example line: "read threads=4 pattern=random duration=60s"
+// INPUT:   path = scenario file path
+//          parse_control = control array for parsing phase options
+// OUTPUT:  status, 0=parsed OK, otherwise parsing error, messages output to console
+//          update scenario[], scenarioCount
+//---
+#define LINE_MAX_CHARS 256      // maximum scenario line length
+#define LINE_MAX_TOKENS 16      // maximum phase type and options per line
+int handlerScenario( char* path, OPTION_ENTRY parse_control[] )
+{
+FILE* scenarioFile = NULL;            // scenario file, text
+char line[LINE_MAX_CHARS];            // current line
+char* tokens[LINE_MAX_TOKENS];        // phase type and options strings
+int tokenCount = 0;                   // number of strings in the current line
+int lineNumber = 0;                   // current line number, for error messages
+int type = 0;                         // phase type, index in the mmbScenarioNames[]
+char* p = NULL;                       // transit pointer
+
+scenarioFile = fopen( path, "r" );
+if ( scenarioFile == NULL )
+    {
+    printf( "ERROR, SCENARIO FILE NOT OPENED: %s\n", path );
+    return 1;
+    }
+scenarioCount = 0;
+while ( fgets( line, LINE_MAX_CHARS, scenarioFile ) != NULL )
+    {
+    lineNumber++;
+    p = strchr( line, '#' );          // cut comment
+    if ( p != NULL ) *p = 0;
+    tokenCount = 0;
+    for ( p = strtok( line, " \t\r\n" ); p != NULL; p = strtok( NULL, " \t\r\n" ) )
+        {
+        if ( tokenCount >= LINE_MAX_TOKENS )
+            {
+            printf( "ERROR, SCENARIO LINE %d: TOO MANY OPTIONS\n", lineNumber );
+            fclose( scenarioFile );
+            return 1;
+            }
+        tokens[tokenCount++] = p;
+        }
+    if ( tokenCount == 0 ) continue;  // skip empty and comment lines
+    // detect phase type by comparision from list
+    for ( type=0; type<MMB_SCENARIO_TYPES; type++ )
+        {
+        if ( strcmp( tokens[0], mmbScenarioNames[type] ) == 0 ) break;
+        }
+    if ( type == MMB_SCENARIO_TYPES )
+        {
+        printf( "ERROR, SCENARIO LINE %d: PHASE NOT RECOGNIZED: %s\n", lineNumber, tokens[0] );
+        fclose( scenarioFile );
+        return 1;
+        }
+    if ( scenarioCount >= MMB_SCENARIO_MAX )
+        {
+        printf( "ERROR, SCENARIO LINE %d: TOO MANY PHASES\n", lineNumber );
+        fclose( scenarioFile );
+        return 1;
+        }
+    // phase options, first string is phase type, skipped same as application name
+    mmb_phase_init( &context, &scenarioEntry, type );
+    if ( handlerInput( tokenCount, tokens, parse_control ) != 0 )
+        {
+        printf( "ERROR, SCENARIO LINE %d\n", lineNumber );
+        fclose( scenarioFile );
+        return 1;
+        }
+    scenario[scenarioCount++] = scenarioEntry;
+    }
+fclose( scenarioFile );
+return 0;
+}
+
+//--- Handler for output scenario phases list ---
+//---
+void handlerScenarioList( void )
+    {
+    int i = 0;
+    MMB_PHASE* phase = NULL;
+    printf( "\nScenario:\n" );
+    for ( i=0; i<scenarioCount; i++ )
+        {
+        phase = &scenario[i];
+        printf( " %-6d%-11s", i+1, mmbScenarioNames[phase->type] );
+        switch( phase->type )
+            {
+            case MMB_SCENARIO_CREATE:
+                printf( "size=" );
+                printMemorySize( phase->size );
+                printf( " alloc=%s", mmbAllocNames[phase->alloc] );
+                break;
+            case MMB_SCENARIO_PREFAULT:
+                printf( "advice=%s", mmbAdviceNames[phase->advice] );
+                break;
+            case MMB_SCENARIO_READ:
+            case MMB_SCENARIO_WRITE:
+                printf( "threads=%d pattern=%s duration=%dms",
+                        phase->threads, mmbPatternNames[phase->pattern], phase->duration );
+                break;
+            case MMB_SCENARIO_FLUSH:
+                printf( "threads=%d interval=%dms duration=%dms",
+                        phase->threads, phase->interval, phase->duration );
+                break;
+            case MMB_SCENARIO_DELAY:
+                printf( "duration=%dms", phase->duration );
+                break;
+            }
+        if ( phase->background ) printf( " background" );
+        printf( "\n" );
+        }
+    }
+
+//--- Handler for output scenario phases results ---
+//---
+void handlerScenarioResults( void )
+    {
+    int i = 0;
+    MMB_PHASE* phase = NULL;
+    printf( "Phase | Operation | Seconds  | MBPS       | Operations\n" );
+    printf( "-------------------------------------------------------------------------\n\n" );
+    for ( i=0; i<scenarioCount; i++ )
+        {
+        phase = &scenario[i];
+        printf( " %-6d%-11s%8.3f%13.3f%13lld\n",
+                i+1, mmbScenarioNames[phase->type],
+                phase->seconds, phase->mbps, phase->operations );
+        }
+    printf( "\n-------------------------------------------------------------------------\n" );
+    }
+
+//--- Handler for output performance counters, not collected counters shown as n/a ---
+// INPUT:  counters = counters values
+//         divider = divider for values, number of passes for average, 1 for one pass
+//---
+void handlerCounters( MMB_COUNTERS* counters, int divider )
+    {
+    int i = 0;
+    printf( "       " );
+    for ( i=0; i<MMB_COUNTERS_COUNT; i++ )
+        {
+        if ( counters->valid & ( 1 << i ) )
+            {
+            printf( " %s=%.0f", mmbCounterNames[i], counters->values[i] / divider );
+            }
+        else
+            {
+            printf( " %s=n/a", mmbCounterNames[i] );
+            }
+        }
+    printf( "\n" );
+    }
+
 //--- Handler for output current string at test progress ---
-// INPUT:  char* stepName = name of step
+// INPUT:  int   phase = measured phase, MMB_WRITE ... MMB_REFAULT, selects step name and statistic array
 //         int   stepNumber = number of step (pass)
-//         double statArray[] = statistic array, stepNumber entries used
 //---
-void handlerProgress( char stepName[], int stepNumber, double statArray[] )
+void handlerProgress( int phase, int stepNumber )
     {
     	
-    double currentMBPS = statArray[stepNumber];
-    
-    calculateStatistics( statArray, stepNumber + 1,
-                        &resultMedian, &resultAverage,
-                        &resultMinimum, &resultMaximum );
-/*
-    int i = 0;
-    int j = 8;
-    j -= printf ( " %d", stepNumber+1 );
-    for ( i=0; i<j; i++ ) { printf( " " ); }
-    
-    j = 11;
-    j -= printf ( "%s", stepName );
-    for ( i=0; i<j; i++ ) { printf( " " ); }
-    
-    j = 11;
-    j -= printf( "%.3f", statArray[stepNumber] );
-    for ( i=0; i<j; i++ ) { printf( " " ); }
-    
-    j = 11;
-    j -= printf( "%.3f", resultMedian );
-    for ( i=0; i<j; i++ ) { printf( " " ); }
-    
-    j = 11;
-    j -= printf( "%.3f", resultAverage );
-    for ( i=0; i<j; i++ ) { printf( " " ); }
-    
-    j = 11;
-    j -= printf( "%.3f", resultMinimum );
-    for ( i=0; i<j; i++ ) { printf( " " ); }
-    
-    j = 11;
-    j -= printf( "%.3f", resultMaximum );
-    for ( i=0; i<j; i++ ) { printf( " " ); }
+    double currentMBPS = context.logs[phase][stepNumber];
     
-    printf ( "\n" );
-*/
+    mmb_stats( &context, phase, stepNumber + 1, &results );
 
 	printf( " %-6d%-11s%8.3f%11.3f%11.3f%11.3f%11.3f\n",
 	        stepNumber+1,
-	        stepName,
-	        // statArray[stepNumber],
+	        mmbPhaseNames[phase],
 	        currentMBPS,
-	        //
-	        resultMedian,
-	        resultAverage,
-	        resultMinimum,
-	        resultMaximum
+	        results.median,
+	        results.average,
+	        results.minimum,
+	        results.maximum
 	      );
 	
+	//--- Performance counters at timed region of this phase, if enabled ---
+	if ( mmb_counted( &context, phase ) ) handlerCounters( &context.counters[phase][stepNumber], 1 );
+	
 	}
 
+//--- Handler for output latency versus throughput curve, rate sweep mode ---
+//---
+void handlerSweep( void )
+    {
+    int i = 0;
+    printf( "\nLatency versus throughput (rate sweep):\n" );
+    printf( "Pass | Offered(pg/s) | Achieved(pg/s) | p50(us)    | p99(us)\n" );
+    printf( "-------------------------------------------------------------------------\n\n" );
+    for ( i=0; i<context.repeats; i++ )
+        {
+        printf( " %-6d%-16d%-17.0f%-13.3f%.3f\n",
+                i+1, mmb_rate( &context, i ), context.logs[MMB_ACHIEVED][i],
+                context.logs[MMB_RP50][i], context.logs[MMB_RP99][i] );
+        }
+    printf( "\n-------------------------------------------------------------------------\n" );
+    }
+
+//--- Handler for output throughput and refault rate versus available memory, memory sweep mode ---
+//---
+void handlerMemorySweep( void )
+    {
+    int i = 0;
+    printf( "\nThroughput and refault rate versus memory (memory sweep):\n" );
+    printf( "Pass | Balloon(MB) | Limit(MB) | Write MBPS | Read MBPS  | Faults/page\n" );
+    printf( "-------------------------------------------------------------------------\n\n" );
+    for ( i=0; i<context.repeats; i++ )
+        {
+        printf( " %-6d%-14.1f%-12.1f%-13.3f%-13.3f%.3f\n",
+                i+1, mmb_pressure( &context, i ) / 1048576.0, mmb_limit( &context, i ) / 1048576.0,
+                context.logs[MMB_WRITE][i], context.logs[MMB_READ][i], context.logs[MMB_RFAULTS][i] );
+        }
+    printf( "\n-------------------------------------------------------------------------\n" );
+    }
+
+//--- Helper for write JSON string, with escape ---
+// INPUT:  f = output file
+//         text = string
+//---
+void jsonString( FILE* f, char* text )
+    {
+    fputc( '"', f );
+    for ( ; *text!=0; text++ )
+        {
+        if ( ( *text == '"' ) || ( *text == '\\' ) ) fprintf( f, "\\%c", *text );
+        else if ( *text == '\n' ) fprintf( f, "\\n" );
+        else if ( (unsigned char)*text < ' ' ) fprintf( f, "\\u%04x", *text );
+        else fputc( *text, f );
+        }
+    fputc( '"', f );
+    }
+
+//--- Helper for write JSON number, null if not finite, for example MBPS of zero time interval ---
+// INPUT:  f = output file
+//         value = number
+//---
+void jsonNumber( FILE* f, double value )
+    {
+    if ( isfinite( value ) ) fprintf( f, "%.3f", value );
+    else fprintf( f, "null" );
+    }
+
+//--- Handler for save options and results to JSON file, for batch runs and regression tracking ---
+// INPUT:  option_list = options list, values written as parsed
+// OUTPUT: 0 = OK, 1 = file error
+// Per phase statistics and per pass results written for measurement passes,
+// per phase results written for scenario.
+//---
+int handlerJson( OPTION_ENTRY option_list[] )
+    {
+    FILE* f = NULL;
+    int i = 0, j = 0, count = 0;
+    MMB_PHASE* p = NULL;
+    f = fopen( jsonPath, "wt" );
+    if ( f == NULL )
+        {
+        printf( "ERROR, JSON FILE: %s\n", jsonPath );
+        return 1;
+        }
+    fprintf( f, "{\n  \"title\": " );
+    jsonString( f, TITLE );
+    fprintf( f, ",\n  \"options\": {" );
+    for ( i=0; option_list[i].name!=NULL; i++ )
+        {
+        fprintf( f, "%s\n    ", i ? "," : "" );
+        jsonString( f, option_list[i].name );
+        fprintf( f, ": " );
+        switch( option_list[i].routine )
+            {
+            case INTPARM:
+            case TIMEPARM:
+                fprintf( f, "%d", *(int *) option_list[i].data );
+                break;
+            case MEMPARM:
+                fprintf( f, "%llu", (unsigned long long) *(size_t *) option_list[i].data );
+                break;
+            case SELPARM:
+                jsonString( f, option_list[i].values[ *(int *) option_list[i].data ] );
+                break;
+            case STRPARM:
+                jsonString( f, *(char **) option_list[i].data );
+                break;
+            default:
+                fprintf( f, "null" );
+                break;
+            }
+        }
+    fprintf( f, "\n  },\n  \"system\": { \"page\": %llu, \"granularity\": %llu }",
+             (unsigned long long) context.pageSize, (unsigned long long) context.granularity );
+    if ( scenarioPath != scenarioNone )
+        {
+        fprintf( f, ",\n  \"scenario\": [" );
+        for ( i=0; i<scenarioCount; i++ )
+            {
+            p = &scenario[i];
+            fprintf( f, "%s\n    { \"phase\": %d, \"type\": ", i ? "," : "", i+1 );
+            jsonString( f, mmbScenarioNames[p->type] );
+            fprintf( f, ", \"seconds\": " );
+            jsonNumber( f, p->seconds );
+            fprintf( f, ", \"megabytes\": " );
+            jsonNumber( f, p->megabytes );
+            fprintf( f, ", \"mbps\": " );
+            jsonNumber( f, p->mbps );
+            fprintf( f, ", \"operations\": %lld }", p->operations );
+            }
+        fprintf( f, "\n  ]" );
+        }
+    else
+        {
+        fprintf( f, ",\n  \"phases\": [" );
+        for ( i=0; i<MMB_PHASES; i++ )
+            {
+            if ( mmb_enabled( &context, i ) == 0 ) continue;
+            mmb_stats( &context, i, context.repeats, &results );
+            fprintf( f, "%s\n    { \"name\": ", count++ ? "," : "" );
+            jsonString( f, mmbPhaseNames[i] );
+            fprintf( f, ", \"median\": " );
+            jsonNumber( f, results.median );
+            fprintf( f, ", \"average\": " );
+            jsonNumber( f, results.average );
+            fprintf( f, ", \"minimum\": " );
+            jsonNumber( f, results.minimum );
+            fprintf( f, ", \"maximum\": " );
+            jsonNumber( f, results.maximum );
+            fprintf( f, ", \"passes\": [" );
+            for ( j=0; j<context.repeats; j++ )
+                {
+                if ( j ) fprintf( f, ", " );
+                jsonNumber( f, context.logs[i][j] );
+                }
+            fprintf( f, "] }" );
+            }
+        fprintf( f, "\n  ]" );
+        }
+    fprintf( f, "\n}\n" );
+    if ( fclose( f ) != 0 )
+        {
+        printf( "ERROR, JSON FILE: %s\n", jsonPath );
+        return 1;
+        }
+    return 0;
+    }
 
+//--- Handler for benchmark library error, close opened objects ---
+// INPUT:  status = status returned by library function
+// OUTPUT: exit code, 2 means operation error
+//---
+int handlerError( int status )
+    {
+    printf( "%s\n", context.errorText );
+    mmb_teardown( &context );
+    return 2;
+    }
 
 //---------- Application entry point -------------------------------------------
 
 int main( int argc, char** argv )
 {
+int status = 0;
+int phase = 0;
+
 //--- Start message ---
 printf( "\n%s\n\n", TITLE );
 
+//--- Options defaults ---
+mmb_init( &context );
+
 //--- Parse command line ---
 if ( handlerInput( argc, argv, ipb_list ) != 0 ) return 1;
 
@@ -697,299 +1049,197 @@ printf( "Start conditions:\n" );
 //--- Print transit (config) parameters ---
 handlerOutput( tpb_list, IPB_TABS );
 
-//--- Check start parameters validity and compatibility ---
-if ( ( fileSize < FILE_SIZE_MIN ) | ( fileSize > FILE_SIZE_MAX ) )
+//--- Load trace file, if used ---
+if ( tracePath != traceNone )
     {
-    printf("\nBAD PARAMETER: file size must be from " );
-    printMemorySize( FILE_SIZE_MIN );
-    printf(" to ");
-    printMemorySize( FILE_SIZE_MAX );
+    if ( mmb_trace_load( &context, tracePath, &trace ) != MMB_OK )
+        {
+        printf( "\nERROR, TRACE FILE: %s\n", context.errorText );
+        return 1;
+        }
+    context.trace = &trace;
+    printf( "\nTrace: %u records, %d threads, file size required ", (unsigned int)trace.count, trace.threads );
+    printMemorySize( trace.span );
     printf( "\n" );
-    return 1;
     }
-if ( ( writeDelay < DELAY_MIN ) | ( writeDelay > DELAY_MAX ) )
+
+//--- Load hot set file, if used ---
+if ( hotsetPath != hotsetNone )
     {
-	printf("\nBAD PARAMETER: Write delay must be from %d to %d milliseconds\n", DELAY_MIN, DELAY_MAX );
-    return 1;
+    if ( mmb_hotset_load( &context, hotsetPath, &hotset ) != MMB_OK )
+        {
+        printf( "\nERROR, HOT SET FILE: %s\n", context.errorText );
+        return 1;
+        }
+    context.hotset = &hotset;
+    printf( "\nHot set: %u offsets\n", (unsigned int)hotset.count );
     }
-if ( ( readDelay < DELAY_MIN ) | ( readDelay > DELAY_MAX ) )
+
+//--- Check start parameters validity and compatibility ---
+if ( mmb_check( &context ) != MMB_OK )
     {
-    printf("\nBAD PARAMETER: Read delay must be from %d to %d milliseconds\n", DELAY_MIN, DELAY_MAX );
+    printf( "\nBAD PARAMETER: %s\n", context.errorText );
     return 1;
     }
-if ( ( repeats < REPEATS_MIN ) | ( repeats > REPEATS_MAX ) )
+if ( context.fileMode == MMB_MODE_EXISTING )
     {
-    printf("\nBAD PARAMETER: Repeats must be from %d to %d times\n", REPEATS_MIN, REPEATS_MAX );
+    printf( "\nExisting file size " );
+    printMemorySize( context.fileSize );
+    printf( ", file not modified\n" );
+    }
+
+//--- Parse, print and check scenario file, if used ---
+if ( ( scenarioPath != scenarioNone ) && ( tracePath != traceNone ) )
+    {
+    printf( "\nBAD PARAMETER: scenario and trace replay not compatible\n" );
     return 1;
     }
+if ( scenarioPath != scenarioNone )
+    {
+    if ( handlerScenario( scenarioPath, spb_list ) != 0 ) return 1;
+    handlerScenarioList();
+    if ( mmb_scenario_check( &context, scenario, scenarioCount ) != MMB_OK )
+        {
+        printf( "\nBAD PARAMETER: %s\n", context.errorText );
+        return 1;
+        }
+    }
 
-//--- Wait for key (Y/N) with list of start parameters ---
-printf("\nStart? (Y/N)" );
-int key = 0;
-key = getchar();
-key = tolower(key);
-if ( key != 'y' )
+//--- Wait for key (Y/N) with list of start parameters, skipped for batch run ---
+if ( batchMode == 0 )
     {
-    printf( "Test skipped.\n" );
-    return 3;
+    printf("\nStart? (Y/N)" );
+    int key = 0;
+    key = getchar();
+    key = tolower(key);
+    if ( key != 'y' )
+        {
+        printf( "Test skipped.\n" );
+        return 3;
+        }
+    printf( "\n" );
     }
-printf( "\n" );
 
-//--- Blank log arrays ---
-int rep = repeats;
-for ( rep=0; rep<10; rep++ )
-	{
-	readLog[rep] = 0.0;
-	writeLog[rep] = 0.0;
-	}
+//--- Run scenario instead of measurement repeats, if scenario used ---
+if ( scenarioPath != scenarioNone )
+    {
+    printf( "\nStart scenario.\n" );
+    status = mmb_scenario( &context, scenario, scenarioCount );
+    if ( status != MMB_OK ) return handlerError( status );
+    handlerScenarioResults();
+    if ( ( jsonPath != jsonNone ) && ( handlerJson( ipb_list ) != 0 ) ) return 2;
+    printf( "\nDone.\n" );
+    return 0;
+    }
 
-//--- Cycle for measurement repeats ---
-// printf("Benchmarking...\n");
 //--- Cycle for measurement repeats ---
 printf( "\nStart benchmarking.\n" );
 printf( "Pass | Operation | MBPS     | Median   | Average  | Minimum  | Maximum\n" );
 printf( "-------------------------------------------------------------------------\n\n" );
 
-for ( rep=0; rep<repeats; rep++ )
-	{
-
-	//--- Create file ---
-	fileHandle = CreateFile( filePath, fileAccess, fileShare, fileSecurity, fileCreate, fileFlags, fileTemplate );
-	if ( fileHandle == NULL )
-		{
-		printf ( "Error create file\n" );
-		return 2;
-		}
-	else
-		{
-		// printf( "File created...\n" );  // make silent version
-		}
-
-	//--- WRITE PHASE: Create mapping object for file ---
-	// mapSizeLow = fileSize & 0xFFFFFFFFLL;
-	// mapSizeHigh = fileSize >> 32;
-	convert64 ( fileSize, &mapSizeLow, &mapSizeHigh );
-	// bug 32/64 fixed
-	mapHandle = CreateFileMapping( fileHandle, mapSecurity, mapProtect, mapSizeHigh, mapSizeLow, mapName );
-	if ( mapHandle == NULL )
-		{
-		printf ( "Error create mapping\n" );
-		return 2;
-		}
-	else
-		{
-		// printf( "Mapping created...\n" );  // make silent version
-		}
-
-	//--- WRITE PHASE: Mapping created object to address space ---
-	mapPointer = MapViewOfFile( mapHandle, viewAccess, viewOffsetHigh, viewOffsetLow, fileSize );
-	if ( mapPointer == NULL )
-		{
-		printf ( "Error create view\n" );
-		return 2;
-		}
-	else
-		{
-		// printf( "View at virtual address %ph created...\n", mapPointer );  // make silent version
-		}
-
-	//--- WRITE PHASE: Fill buffer for write data to file without page faults in the measure time ---
-	// printf("Write buffer...\n");  // make silent version
-	char setData = '1';
-	// memset ( mapPointer, setData, mapSizeLow );  // thsi limits buffer size to 32-bit value
-	memset ( mapPointer, setData, fileSize );
-	// bug with 32/64 fixed
-
-	//--- WRITE PHASE: Flush modified data to file, means write operation, with time measurement ---
-	// printf("Write delay...\n");  // make silent version
-	Sleep(writeDelay);
-	// printf("Write file...\n");  // make silent version
-	//--- start timings ---
-	GetSystemTimeAsFileTime( &ut1.ft );
-	status = FlushViewOfFile( mapPointer, fileSize );
-	GetSystemTimeAsFileTime( &ut2.ft );
-	//--- end timings ---
-	if ( status == 0 )
-		{
-		printf ( "Error flush file\n" );
-		return 2;
-		}
-	else
-		{
-		double megabytes = fileSize;
-		megabytes /= 1048576.0;               // convert from bytes to megabytes
-		double seconds = ut2.lt - ut1.lt;
-		seconds *= TIME_TO_SECONDS;           // convert from 100ns-units to seconds
-		double mbps = megabytes / seconds;
-		// printf( "Flush file OK, write speed = %.3f MBPS\n" , mbps );    // make silent version
-		//
-		// printf( "Pass %d write MBPS = %.3f\n", rep+1, mbps );
-		//
-		writeLog[rep] = mbps;
-		//
-		handlerProgress( "write", rep, writeLog );
-		//
-		}
+status = mmb_setup( &context );
+if ( status != MMB_OK ) return handlerError( status );
 
-	//--- WRITE PHASE: Close mapping object ---
-	status = CloseHandle( mapHandle );
-	if ( status == 0 )
-		{
-		printf ( "Error close mapping\n" );
-		return 2;
-		}
-
-	//--- WRITE PHASE: Close file ---
-	status = CloseHandle( fileHandle );
-	if ( status == 0 )
-		{
-		printf ( "Error close file\n" );
-		return 2;
-		}
-
-	//--- WRITE PHASE: Unmap view of file ---
-	// Note file not deleted for next operations.
-	status = UnmapViewOfFile( mapPointer );
-	if ( status == 0 )
-		{
-		printf ( "Error unmap file\n" );
-		return 2;
-		}
-
-	//--- READ PHASE: Re-Open file ---
-	fileHandle = CreateFile( filePath, fileAccess, fileShare, fileSecurity, fileOpen, fileFlags, fileTemplate );
-	if ( fileHandle == NULL )
-		{
-		printf ( "Error re-open file\n" );
-		return 2;
-		}
-	else
+int rep = 0;
+for ( rep=0; rep<context.repeats; rep++ )
+	{
+	//--- REPLAY PHASE, instead of write and read phases if trace used ---
+	if ( context.trace != NULL )
 		{
-		// printf( "File re-opened...\n" );    // make silent version
+		status = mmb_replay( &context, rep );
+		if ( status != MMB_OK ) return handlerError( status );
+		for ( phase=MMB_REPLAY; phase<=MMB_P99; phase++ ) handlerProgress( phase, rep );
+		continue;
 		}
 	
-	//--- READ PHASE: Re-Create mapping object for file ---
-	// mapSizeLow = fileSize & 0xFFFFFFFFLL;
-	// mapSizeHigh = fileSize >> 32;
-	convert64 ( fileSize, &mapSizeLow, &mapSizeHigh );
-	// bug 32/64 fixed
-	mapHandle = CreateFileMapping( fileHandle, mapSecurity, mapProtect, mapSizeHigh, mapSizeLow, mapName );
-	if ( mapHandle == NULL )
-		{
-		printf ( "Error re-create mapping\n" );
-		return 2;
-		}
-	else
-		{
-		// printf( "Mapping re-created...\n" );    // make silent version
-		}
-
-	//--- READ PHASE: Mapping created object to address space ---
-	mapPointer = MapViewOfFile( mapHandle, viewAccess, viewOffsetHigh, viewOffsetLow, fileSize );
-	if ( mapPointer == NULL )
+	//--- STARTUP PHASE, instead of write and read phases if existing file mapped ---
+	if ( context.fileMode == MMB_MODE_EXISTING )
 		{
-		printf ( "Error re-create view\n" );
-		return 2;
+		status = mmb_startup( &context, rep );
+		if ( status != MMB_OK ) return handlerError( status );
+		for ( phase=MMB_OPEN; phase<=MMB_HOT; phase++ )
+			{
+			if ( mmb_enabled( &context, phase ) ) handlerProgress( phase, rep );
+			}
+		continue;
 		}
-	else
-		{
-		// printf( "View at virtual address %ph re-created...\n", mapPointer );    // make silent version
-		}
-
-	//--- READ PHASE:  page walk means swap operation, with time measurement ---
-	// printf("Read delay...\n");    // make silent version
-	Sleep(readDelay);
-	// printf("Read file by page walk...\n");     // make silent version
-
-	int walkSize = PAGE_WALK_STEP;
-	char walkData = 0;
-	char* readPointer = (char *) mapPointer;
-	int readCount = 0;
-	int readLimit = mapSizeLow / walkSize;
-
-	//--- start timings ---
-	GetSystemTimeAsFileTime( &ut1.ft );
-	for ( readCount=0; readCount<readLimit; readCount++ )
-		{
-		walkData = *readPointer;   // this causes swapping or DAX map for adressed pages
-		readPointer += walkSize;
-		}
-	GetSystemTimeAsFileTime( &ut2.ft );
-	//--- end timings ---
-	if ( status == 0 )  // status not updated above, use previous (bug)
-		{
-		printf ( "Error read file\n" );
-		return 2;
-		}
-	else
-		{
-		double megabytes = fileSize;
-		megabytes /= 1048576.0;               // convert from bytes to megabytes
-		double seconds = ut2.lt - ut1.lt;
-		seconds *= TIME_TO_SECONDS;           // convert from 100ns-units to seconds
-		double mbps = megabytes / seconds;
-		// printf( "Read page walk OK, read speed = %.3f MBPS\n\n" , mbps );     // make silent version
-		//
-		// printf( "Pass %d read  MBPS = %.3f\n", rep+1, mbps );
-		//
-		readLog[rep] = mbps;
-		//
-		handlerProgress( "read", rep, readLog );
-		//
-		}
-
-	//--- READ PHASE: Close mapping object ---
-	status = CloseHandle( mapHandle );
-	if ( status == 0 )
+	
+	//--- WRITE PHASE ---
+	status = mmb_write( &context, rep );
+	if ( status != MMB_OK ) return handlerError( status );
+	handlerProgress( MMB_WRITE, rep );
+	
+	//--- READ PHASE, with write-touch ---
+	status = mmb_read( &context, rep );
+	if ( status != MMB_OK ) return handlerError( status );
+	for ( phase=MMB_READ; phase<=MMB_FAULT; phase++ )
 		{
-		printf ( "Error close mapping\n" );
-		return 2;
+		if ( mmb_enabled( &context, phase ) ) handlerProgress( phase, rep );
 		}
-
-	//--- READ PHASE: Close file ---
-	status = CloseHandle( fileHandle );
-	if ( status == 0 )
+	for ( phase=MMB_RFAULTS; phase<=MMB_RP99; phase++ )
 		{
-		printf ( "Error close file\n" );
-		return 2;
+		if ( mmb_enabled( &context, phase ) ) handlerProgress( phase, rep );
 		}
-
-	//--- READ PHASE: Unmap view of file ---
-	// Note file not deleted for next operations.
-	status = UnmapViewOfFile( mapPointer );
-	if ( status == 0 )
+	if ( mmb_enabled( &context, MMB_ACHIEVED ) ) handlerProgress( MMB_ACHIEVED, rep );
+	
+	//--- PUNCH PHASE ---
+	status = mmb_punch( &context, rep );
+	if ( status != MMB_OK ) return handlerError( status );
+	if ( mmb_enabled( &context, MMB_REFAULT ) ) handlerProgress( MMB_REFAULT, rep );
+	
+	//--- STRADDLE PHASE ---
+	status = mmb_straddle( &context, rep );
+	if ( status != MMB_OK ) return handlerError( status );
+	for ( phase=MMB_ALIGNED; phase<=MMB_STRADDLE; phase++ )
 		{
-		printf ( "Error unmap file\n" );
-		return 2;
+		if ( mmb_enabled( &context, phase ) ) handlerProgress( phase, rep );
 		}
-
-	//--- READ PHASE: Delete file ---
-	status = DeleteFile( filePath );
-	if ( status == 0 )
+	for ( phase=MMB_AFAULTS; phase<=MMB_SFAULTS; phase++ )
 		{
-		printf ( "Error delete file\n" );
-		return 2;
+		if ( mmb_enabled( &context, phase ) ) handlerProgress( phase, rep );
 		}
-	
 	}
+
+status = mmb_teardown( &context );
+if ( status != MMB_OK ) return handlerError( status );
 	
 printf( "\n-------------------------------------------------------------------------\n" );
 
-//--- Print output parameters, read results ---
-printf( "\nWrite statistics (MBPS):\n" );
-calculateStatistics(  writeLog, repeats,
-                     &resultMedian, &resultAverage,
-                     &resultMinimum, &resultMaximum );
-handlerOutput( opb_list, OPB_TABS );
+//--- Print output parameters, results per measured phase ---
+for ( phase=0; phase<MMB_PHASES; phase++ )
+    {
+    if ( mmb_enabled( &context, phase ) )
+        {
+        printf( "\n%s\n", statTitles[phase] );
+        mmb_stats( &context, phase, context.repeats, &results );
+        handlerOutput( opb_list, OPB_TABS );
+        if ( mmb_counted( &context, phase ) && ( context.repeats > 0 ) )
+            {
+            int i = 0, j = 0;
+            MMB_COUNTERS sum;
+            memset( &sum, 0, sizeof(sum) );
+            sum.valid = context.counters[phase][0].valid;
+            for ( i=0; i<context.repeats; i++ )
+                {
+                sum.valid &= context.counters[phase][i].valid;
+                for ( j=0; j<MMB_COUNTERS_COUNT; j++ ) sum.values[j] += context.counters[phase][i].values[j];
+                }
+            printf( "Counters average per pass:\n" );
+            handlerCounters( &sum, context.repeats );
+            }
+        }
+    }
+
+//--- Latency versus throughput curve, if rate sweep, or refault rate versus memory, if memory sweep ---
+if ( mmb_enabled( &context, MMB_RP50 ) && ( context.sweepMode == MMB_SWEEP_RATE ) ) handlerSweep();
+if ( mmb_enabled( &context, MMB_RFAULTS ) && ( context.sweepMode == MMB_SWEEP_MEMORY ) ) handlerMemorySweep();
 
-//--- Print output parameters, read results ---
-printf( "\nRead statistics (MBPS):\n" );
-calculateStatistics(  readLog, repeats,
-                     &resultMedian, &resultAverage,
-                     &resultMinimum, &resultMaximum );
-handlerOutput( opb_list, OPB_TABS );
+//--- Save results to JSON file, if used ---
+if ( ( jsonPath != jsonNone ) && ( handlerJson( ipb_list ) != 0 ) ) return 2;
 
 //--- Exit ---
+if ( context.trace != NULL ) mmb_trace_free( &trace );
+if ( context.hotset != NULL ) mmb_hotset_free( &hotset );
 printf( "\nDone.\n" );
 return 0;
 }
@@ -0,0 +1,2530 @@
+/*
+Memory mapped file io test. (C) IC Book Labs.
+Benchmark library implementation: phases, timings, statistics.
+No global state, all data located in the MMB_CONTEXT structure.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#if defined(_WIN32)
+#include <windows.h>
+#include <winioctl.h>
+#include <psapi.h>
+#else
+#include "mmb_posix.h"
+#endif
+#include "mmb.h"
+
+//--- Defaults definitions ---
+#define FILE_PATH   "myfile.bin"       // default file path and name
+#define FILE_SIZE   ( 1024*1024*1024 ) // default file size, bytes
+#define WRITE_DELAY 100                // default delay from Start to Write in milliseconds, argument of Sleep()
+#define READ_DELAY  100                // default delay from Write end to Read in milliseconds, argument of Sleep()
+#define MEASURE_REPEATS 5              // default number of measurement repeats
+#define ALLOC_MODE  MMB_ALLOC_EXTEND       // default file blocks allocation mode
+#define PUNCH_MODE  0                  // default punch-hole phase mode, 0=off
+#define REUSE_MODE  MMB_REUSE_NONE         // default file reuse mode, create and delete file per pass
+#define MAPPING_MODE MMB_MAPPING_SHARED    // default mapping mode for read phase
+#define TARGET_MODE MMB_TARGET_FILE        // default mapping target, file on storage device
+#define REPLAY_MODE MMB_REPLAY_OPEN        // default trace replay mode, honoring timestamps
+#define COUNTERS_MODE 0                // default performance counters mode, 0=off
+#define FLUSH_MODE  MMB_FLUSH_SYNC         // default write phase flush mode, flush after all view filled
+#define FLUSH_CHUNK ( 4*1024*1024 )     // default chunk size for async and pipelined flush modes, bytes
+#define PRESSURE_SIZE 0                // default locked balloon size, bytes, 0=no memory pressure
+#define MEMORY_LIMIT  0                // default working set limit, bytes, 0=no limit
+#define TOUCH_MODE  0                  // default write-touch for shared mapping, 0=off, private mapping always touched
+#define TOUCH_RATE  0                  // default read walk rate, pages per second, 0=closed-loop walk
+#define SWEEP_MODE  MMB_SWEEP_OFF      // default sweep mode, all passes same
+#define FILE_MODE   MMB_MODE_CREATE        // default file mode, file created and written by benchmark
+#define FIRST_PAGES 16                 // default number of first pages touched at startup of existing file
+#define CACHE_MODE  MMB_CACHE_WARM         // default file cache state before startup of existing file
+#define VIEW_OFFSET 0                  // default view offset in file, bytes
+#define VIEW_ALIGN  0                  // default walk displacement from view start, bytes, 0=page aligned walk
+#define STRADDLE_MODE 0                // default page-straddling probe phase mode, 0=off
+// Default page walk step is system page size, detected by mmb_init; step 512 walks by sectors, 2M by huge pages.
+
+//--- Limits definitions ---
+#define FILE_SIZE_MIN  4096            // minimum file size 4096 bytes
+#if MMB_64BIT
+#define FILE_SIZE_MAX  ( 64ULL*1024*1024*1024 ) // maximum file size 64 gigabytes, for 64-bit address space
+#else
+#define FILE_SIZE_MAX  ( 1536*1024*1024 ) // maximum file size 1.5 gigabytes
+#endif
+#define DELAY_MIN      0               // minimum delay value, 0 milliseconds
+#define DELAY_MAX      100000          // maximum delay value, 100000 milliseconds = 100 seconds
+#define REPEATS_MIN    0               // minimum number of measurement repeats
+#define REUSE_MIN      MMB_REUSE_NONE      // minimum file reuse mode
+#define REUSE_MAX      MMB_REUSE_VIEW      // maximum file reuse mode
+#define THREADS_MIN    1               // minimum number of threads per scenario phase
+#define THREADS_MAX    64              // maximum number of threads per scenario phase
+#define CHUNK_MAX      FILE_SIZE_MAX   // maximum flush chunk size, minimum is page size
+#define PRESSURE_MAX   FILE_SIZE_MAX   // maximum locked balloon size
+#define LIMIT_MIN      ( 16*1024*1024 ) // minimum working set limit
+#define LIMIT_MAX      FILE_SIZE_MAX   // maximum working set limit
+#define RATE_MIN       0               // minimum read walk rate, 0 means closed-loop walk
+#define RATE_MAX       100000000       // maximum read walk rate, pages per second
+#define FIRST_MIN      0               // minimum number of first pages touched at startup
+#define FIRST_MAX      1000000000      // maximum number of first pages touched at startup
+#define BALLOON_MARGIN ( 16*1024*1024 ) // working set reserve above balloon, for code, stack and mapped pages
+#define STEP_MAX       ( 1024*1024*1024 ) // maximum page walk step, 1 gigabyte huge page, minimum is page size
+#define STRADDLE_WINDOW ( 64*1024 )    // fault-around window of straddle phase, Linux fault_around_bytes default
+#define STRADDLE_GROUP 4               // fault-around windows per probe group of straddle phase
+#define STRADDLE_WORD  8               // straddle phase probe size, bytes, split half per page
+
+//--- Timer constant ---
+#define SECONDS_TO_MICROSECONDS 1000000.0   // multiply by this to convert seconds to microseconds
+#define SCHEDULE_SPIN_MS        20          // open-loop wait spins below this, above 15.6 ms default Windows timer tick
+
+//--- File blocks allocation constant ---
+#define ALLOC_CHUNK     ( 1024*1024 )   // buffer size for write zeroes, must be multiple of UNBUFFERED_ALIGN
+#define UNBUFFERED_ALIGN 4096       // size unit of unbuffered write, multiple of 512 and 4K sectors
+
+//--- File preparation after open, select by openView caller ---
+#define PREPARE_NONE   0    // use file as is
+#define PREPARE_ALLOC  1    // allocate file blocks by allocation mode
+#define PREPARE_PUNCH  2    // deallocate all file blocks, punch hole
+
+//--- Data written to file by write phase ---
+#define SET_DATA  '1'
+
+//--- Context owning process-wide working set limits and locked balloon, NULL if none ---
+// Only process-wide state of library: second context with pressure or limit refused, not clobbers first.
+static void* volatile limitsOwner = NULL;
+
+//--- Names for options selected from text strings ---
+char* mmbAllocNames[]   = { "extend", "sparse", "fallocate", "prezero" };
+char* mmbPunchNames[]   = { "off", "on" };
+char* mmbReuseNames[]   = { "off", "file", "view" };
+char* mmbMappingNames[] = { "shared", "private", "readonly" };
+char* mmbTargetNames[]  = { "file", "anon", "memfd", "tmpfs", "pmem-dir" };
+char* mmbPhaseNames[]   = { "write", "read", "touch", "fault(us)", "refault", "replay", "p50(us)", "p99(us)", "faults/pg",
+                            "rp50(us)", "rp99(us)", "open(us)", "map(us)", "view(us)", "first(us)",
+                            "start(us)", "hotset(us)", "aligned(us)", "straddle(us)", "achieved", "afaults/pr",
+                            "sfaults/pr" };
+char* mmbScenarioNames[] = { "create", "prefault", "read", "write", "flush", "delay", "delete" };
+char* mmbPatternNames[] = { "seq", "random" };
+char* mmbAdviceNames[]  = { "willneed", "touch" };
+char* mmbReplayNames[]  = { "open", "closed" };
+char* mmbCountersNames[] = { "off", "on" };
+char* mmbCounterNames[] = { "cycles", "instructions", "dTLB-misses", "page-walks", "LLC-misses",
+                            "ctx-switches", "page-faults", "kernel(us)", "user(us)" };
+char* mmbFlushNames[]   = { "sync", "async", "pipelined" };
+char* mmbSweepNames[]   = { "off", "rate", "memory" };
+char* mmbModeNames[]    = { "create", "open-existing" };
+char* mmbCacheNames[]   = { "warm", "cold" };
+char* mmbStraddleNames[] = { "off", "on" };
+char* mmbTouchNames[]   = { "off", "on" };
+
+//--- Constant parameters of CreateFile, CreateFileMapping, MapViewOfFile functions ---
+static const DWORD fileAccess = GENERIC_READ | GENERIC_WRITE;     // file access mode
+static const DWORD fileShare  = 0;                                // file share mode, not used
+static const DWORD fileCreate = CREATE_ALWAYS;                    // file create mode, at start before write
+static const DWORD fileOpen   = OPEN_ALWAYS;                      // file open mode, after write before read
+static const DWORD targetFlags[] =                                // file attributes per target
+    {
+    FILE_ATTRIBUTE_NORMAL | FILE_FLAG_WRITE_THROUGH | FILE_FLAG_NO_BUFFERING | FILE_FLAG_SEQUENTIAL_SCAN,
+    0,                                               // anonymous memory, no file
+    0,                                               // pagefile-backed section, no file
+    FILE_ATTRIBUTE_TEMPORARY,                        // temporary file, cached
+    FILE_ATTRIBUTE_NORMAL                            // DAX file, page cache bypassed by volume
+    };
+static const DWORD mapProtects[] = { PAGE_READWRITE, PAGE_WRITECOPY, PAGE_READONLY };              // protection per mapping mode
+static const DWORD viewAccesses[] = { FILE_MAP_ALL_ACCESS, FILE_MAP_COPY, FILE_MAP_READ };          // access per mapping mode
+
+//--- Data for timings and benchmarks ---
+typedef union
+    {
+    FILETIME ft;           // return of GetProcessTimes
+    long long lt;          // access as 64-bit value
+    } UNITIME;
+
+//--- Scenario worker thread data ---
+typedef struct
+    {
+    MMB_CONTEXT* ctx;          // benchmark context, view mapped by create phase
+    MMB_PHASE* phase;          // scenario phase executed by this thread
+    int index;                 // number of thread in the phase, 0 ... threads-1
+    volatile LONG* stop;       // nonzero means stop request for background phase
+    LARGE_INTEGER deadline;    // QueryPerformanceCounter value for stop by duration, 0 means no limit
+    long long operations;      // number of touched pages or flushes by this thread
+    int status;                // nonzero means operation error
+    } WORKER;
+
+//--- Scenario phase execution state, for run background phases with next phases ---
+typedef struct
+    {
+    MMB_PHASE* phase;               // scenario phase
+    HANDLE threads[THREADS_MAX];    // thread handles
+    WORKER workers[THREADS_MAX];    // thread data
+    int count;                      // number of started threads
+    LARGE_INTEGER start;            // QueryPerformanceCounter value at phase start
+    } PHASE_RUN;
+
+//--- Trace replay worker thread data ---
+typedef struct
+    {
+    MMB_CONTEXT* ctx;          // benchmark context, view mapped by replay phase
+    size_t* indexes;           // indexes of trace records replayed by this thread, in recorded order
+    size_t count;              // number of records replayed by this thread
+    LARGE_INTEGER start;       // QueryPerformanceCounter value at replay start, base for intended times
+    LARGE_INTEGER frequency;   // QueryPerformanceFrequency value
+    long long bytes;           // number of accessed bytes by this thread
+    } REPLAY_WORKER;
+
+//--- Pipelined flush background thread data ---
+typedef struct
+    {
+    MMB_CONTEXT* ctx;          // benchmark context, view mapped by write phase
+    HANDLE ready;              // semaphore, released by foreground thread per filled chunk
+    size_t chunks;             // number of chunks for flush
+    int status;                // nonzero means flush error
+    } FLUSHER;
+
+//--- Trace file constants ---
+#define TRACE_SIGNATURE      "MMBTRACE"   // binary trace file signature, 8 chars, text trace otherwise
+#define TRACE_SIGNATURE_SIZE 8
+#define TRACE_RECORD_SIZE    20           // binary record: offset 8, length 4, delta 4, thread 2, op 1, reserved 1
+#define TRACE_LINE_MAX       256          // maximum text trace line length
+#define TRACE_GROW           4096         // records array grow step
+
+//--- Hot set file constants ---
+#define HOTSET_LINE_MAX      256          // maximum hot set line length
+#define HOTSET_GROW          4096         // offsets array grow step
+
+//--- Conditional methods definition for 32 and 64-bit platforms ---
+#if MMB_64BIT
+static void convert64( size_t value64, DWORD *low32, DWORD *high32 )
+	{
+	*low32 = value64 & 0xFFFFFFFFLL;
+	*high32 = value64 >> 32;
+	}
+#else
+static void convert64( size_t value64, DWORD *low32, DWORD *high32 )
+	{
+	*low32 = value64;
+	*high32 = 0;
+	}
+#endif
+
+//--- Helper method for store error description to context ---
+// INPUT:   ctx = benchmark context
+//          status = status code for return, MMB_BAD_PARAMETER or MMB_ERROR
+//          format = printf-style format string and arguments
+// OUTPUT:  status code, same as input
+//---
+static int setError( MMB_CONTEXT* ctx, int status, const char* format, ... )
+    {
+    va_list args;
+    va_start( args, format );
+    vsnprintf( ctx->errorText, MMB_ERROR_MAX, format, args );
+    va_end( args );
+    return status;
+    }
+
+//--- Helper method for read performance counters, process-wide ---
+// Windows: process cycles, page faults, kernel and user time. Hardware events
+// (instructions, TLB, page walks, cache misses) and context switches not available
+// without kernel driver or ETW session, these counters never marked valid.
+// Linux: page faults, kernel and user time, hardware and context switch events
+// are perf events, counted from enable, see startCounters and storeCounters.
+// INPUT:   ctx = benchmark context, counters read only if enabled
+//          sample = pointer to counters for update, absolute values
+//---
+#if !defined(_WIN32) && ( ( PERF_EVENT_CYCLES != MMB_COUNTER_CYCLES ) || ( PERF_EVENT_SWITCHES != MMB_COUNTER_SWITCHES ) )
+#error "Perf events must be first benchmark counters, same order"
+#endif
+#define COUNTERS_PROCESS ( ( 1 << MMB_COUNTER_PAGE_FAULTS ) | ( 1 << MMB_COUNTER_KERNEL_TIME ) | ( 1 << MMB_COUNTER_USER_TIME ) )
+static void readCounters( MMB_CONTEXT* ctx, MMB_COUNTERS* sample )
+    {
+    PROCESS_MEMORY_COUNTERS memoryCounters;
+    UNITIME creationTime, exitTime, kernelTime, userTime;
+#if defined(_WIN32)
+    ULONG64 cycles = 0;
+#endif
+    memset( sample, 0, sizeof(MMB_COUNTERS) );
+    memset( &memoryCounters, 0, sizeof(memoryCounters) );
+    GetProcessMemoryInfo( GetCurrentProcess(), &memoryCounters, sizeof(memoryCounters) );
+    GetProcessTimes( GetCurrentProcess(), &creationTime.ft, &exitTime.ft, &kernelTime.ft, &userTime.ft );
+    sample->values[MMB_COUNTER_PAGE_FAULTS] = memoryCounters.PageFaultCount;
+    sample->values[MMB_COUNTER_KERNEL_TIME] = kernelTime.lt / 10.0;    // convert from 100ns-units to microseconds
+    sample->values[MMB_COUNTER_USER_TIME] = userTime.lt / 10.0;
+    sample->valid = COUNTERS_PROCESS;
+#if defined(_WIN32)
+    if ( QueryProcessCycleTime( GetCurrentProcess(), &cycles ) ) sample->valid |= 1 << MMB_COUNTER_CYCLES;
+    sample->values[MMB_COUNTER_CYCLES] = (double)cycles;
+#endif
+    }
+
+//--- Helper method for start performance counters at timed region ---
+// INPUT:   ctx = benchmark context, counters started only if enabled
+//          before = pointer to counters for update, values at start of timed region
+//---
+static void startCounters( MMB_CONTEXT* ctx, MMB_COUNTERS* before )
+    {
+    if ( ctx->countersMode == 0 ) return;
+    readCounters( ctx, before );
+#if !defined(_WIN32)
+    PerfEventsEnable( ctx->perfEvents );    // reset and enable last, nearest to timed region
+#endif
+    }
+
+//--- Helper method for read process page faults count ---
+// OUTPUT:  page faults count, soft and hard faults, 0 if not available
+//---
+static DWORD pageFaults( void )
+    {
+    PROCESS_MEMORY_COUNTERS memoryCounters;
+    memset( &memoryCounters, 0, sizeof(memoryCounters) );
+    GetProcessMemoryInfo( GetCurrentProcess(), &memoryCounters, sizeof(memoryCounters) );
+    return memoryCounters.PageFaultCount;
+    }
+
+//--- Helper method for stop performance counters and store increments at timed region ---
+// INPUT:   ctx = benchmark context, counters stored only if enabled
+//          phase = measured phase, index for counters logs
+//          pass = number of pass, index for counters logs
+//          before = counters read at start of timed region
+//---
+static void storeCounters( MMB_CONTEXT* ctx, int phase, int pass, MMB_COUNTERS* before )
+    {
+    MMB_COUNTERS after;
+    MMB_COUNTERS* result = &ctx->counters[phase][pass];
+    int i = 0;
+    if ( ctx->countersMode == 0 ) return;
+#if !defined(_WIN32)
+    PerfEventsDisable( ctx->perfEvents );
+#endif
+    readCounters( ctx, &after );
+    for ( i=0; i<MMB_COUNTERS_COUNT; i++ ) result->values[i] = after.values[i] - before->values[i];
+    result->valid = after.valid & before->valid;
+#if !defined(_WIN32)
+    for ( i=0; i<PERF_EVENTS_COUNT; i++ )
+        {
+        if ( PerfEventRead( ctx->perfEvents[i], &result->values[i] ) ) result->valid |= 1 << i;   // counted from enable
+        }
+#endif
+    }
+
+//--- Helper method for convert measured interval to megabytes per second ---
+// INPUT:   size = size of processed data, bytes
+//          t1, t2 = results of QueryPerformanceCounter at start and stop of interval
+// OUTPUT:  megabytes per second
+//---
+static double calculateMbps( size_t size, LARGE_INTEGER* t1, LARGE_INTEGER* t2 )
+    {
+    LARGE_INTEGER frequency;
+    double megabytes = size / 1048576.0;   // convert from bytes to megabytes
+    QueryPerformanceFrequency( &frequency );
+    return megabytes * frequency.QuadPart / (double)( t2->QuadPart - t1->QuadPart );
+    }
+
+//--- Helper method for print memory size: bytes/KB/MB/GB, to scratch string ---
+// INPUT:   scratchPointer = pointer to destination string
+//          memsize = memory size for visual, bytes
+// OUTPUT:  number of chars write
+//---
+#define KILO 1024
+#define MEGA 1024*1024
+#define GIGA 1024*1024*1024
+#define PRINT_LIMIT 20
+static int scratchMemorySize( char* scratchPointer, size_t memsize )
+    {
+    double xd = memsize;
+    int nchars = 0;
+    if ( memsize < KILO )
+        {
+        int xi = memsize;
+        nchars = snprintf( scratchPointer, PRINT_LIMIT, "%d bytes", xi );
+        }
+    else if ( memsize < MEGA )
+        {
+        xd /= KILO;
+        nchars = snprintf( scratchPointer, PRINT_LIMIT, "%.2lfK", xd );
+        }
+    else if ( memsize < GIGA )
+        {
+        xd /= MEGA;
+        nchars = snprintf( scratchPointer, PRINT_LIMIT, "%.2lfM", xd );
+        }
+    else
+        {
+        xd /= GIGA;
+        nchars = snprintf( scratchPointer, PRINT_LIMIT, "%.2lfG", xd );
+        }
+    return nchars;
+    }
+
+//--- Helper method for calculate median, average, minimum, maximum ---
+// INPUT:   statArray[] = array of results
+//          statCount = number of actual results in the array, can be smaller than array size
+// OUTPUT:  update variables by input pointers:
+//          statMedian, statAverage, statMin, statMax
+//---
+static void calculateStatistics( double statArray[], int statCount,
+                          double *statMedian, double *statAverage,
+                          double *statMin, double *statMax )
+    {
+    double statSum = 0.0;
+    double statTemp = 0.0;
+    int flag = 0;
+    int i = 0;
+    //--- Minimum, Maximum, Average ---
+    *statMin = statArray[0];
+    *statMax = statArray[0];
+    for ( i=0; i<statCount; i++ )
+        {
+        if ( *statMin > statArray[i] ) { *statMin = statArray[i]; }
+        if ( *statMax < statArray[i] ) { *statMax = statArray[i]; }
+        statSum += statArray[i];
+        }
+    *statAverage = statSum / statCount;
+    //--- Median, first ordering ---
+    flag = 1;
+    while ( flag == 1 )
+        {
+        flag = 0;
+        for ( i=0; i<(statCount-1); i++ )
+            {
+            if ( statArray[i] > statArray[i+1] )
+                {
+                statTemp = statArray[i];
+                statArray[i] = statArray[i+1];
+                statArray[i+1] = statTemp;
+                flag = 1;
+                }
+            }
+        }
+    if ( ( statCount % 2 ) == 0 )
+        {  // median if array length EVEN, average of middle pair
+        i = statCount / 2;
+        *statMedian = ( statArray[i-1] + statArray[i] ) / 2.0;
+        }
+    else
+        {  // median if array length ODD, middle element
+        i = statCount/2;
+        *statMedian = statArray[i];
+        }
+    }
+
+//--- Helper method for set file size without write data ---
+// INPUT:   hFile = handle of opened file
+//          size = new file size, bytes
+// OUTPUT:  status, 0=OK, otherwise error
+//---
+static int setFileSize( HANDLE hFile, size_t size )
+    {
+    LARGE_INTEGER position;
+    position.QuadPart = size;
+    if ( SetFilePointerEx( hFile, position, NULL, FILE_BEGIN ) == 0 ) return 1;
+    if ( SetEndOfFile( hFile ) == 0 ) return 1;
+    position.QuadPart = 0;
+    if ( SetFilePointerEx( hFile, position, NULL, FILE_BEGIN ) == 0 ) return 1;
+    return 0;
+    }
+
+//--- Helper method for prepare file blocks before mapping, select by allocation mode ---
+// INPUT:   hFile = handle of file created for read and write
+//          mode = allocation mode, MMB_ALLOC_EXTEND, MMB_ALLOC_SPARSE, MMB_ALLOC_FALLOCATE, MMB_ALLOC_PREZERO
+//          size = required file size, bytes
+// OUTPUT:  status, 0=OK, otherwise error
+// Note file opened with FILE_FLAG_NO_BUFFERING, prezero writes must be
+// sector aligned, file size truncated after write if it is not sector multiple.
+//---
+static int allocateFile( HANDLE hFile, int mode, size_t size )
+    {
+    DWORD bytesReturned = 0;
+    FILE_ALLOCATION_INFO allocInfo;
+    char* zeroBuffer = NULL;
+    size_t total = 0;
+    DWORD chunk = 0;
+    DWORD written = 0;
+    switch( mode )
+        {
+        case MMB_ALLOC_SPARSE:  // mark file sparse, set end of file, no blocks allocated
+            {
+            if ( DeviceIoControl( hFile, FSCTL_SET_SPARSE, NULL, 0, NULL, 0, &bytesReturned, NULL ) == 0 ) return 1;
+            return setFileSize( hFile, size );
+            }
+        case MMB_ALLOC_FALLOCATE:  // reserve blocks, means fallocate() without data write
+            {
+            allocInfo.AllocationSize.QuadPart = size;
+            if ( SetFileInformationByHandle( hFile, FileAllocationInfo, &allocInfo, sizeof(allocInfo) ) == 0 ) return 1;
+            return setFileSize( hFile, size );
+            }
+        case MMB_ALLOC_PREZERO:  // write zeroes to all file
+            {
+            zeroBuffer = (char *) VirtualAlloc( NULL, ALLOC_CHUNK, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE );
+            if ( zeroBuffer == NULL ) return 1;
+            for ( total=0; total<size; total+=chunk )
+                {
+                chunk = ALLOC_CHUNK;
+                if ( ( size - total ) < ALLOC_CHUNK )
+                    {  // tail rounded up to page, because no buffering mode
+                    chunk = ( ( size - total + UNBUFFERED_ALIGN - 1 ) / UNBUFFERED_ALIGN ) * UNBUFFERED_ALIGN;
+                    }
+                if ( ( WriteFile( hFile, zeroBuffer, chunk, &written, NULL ) == 0 ) || ( written != chunk ) )
+                    {
+                    VirtualFree( zeroBuffer, 0, MEM_RELEASE );
+                    return 1;
+                    }
+                }
+            VirtualFree( zeroBuffer, 0, MEM_RELEASE );
+            return setFileSize( hFile, size );
+            }
+        }
+    return 0;  // MMB_ALLOC_EXTEND, nothing to do, file extended by mapping
+    }
+
+//--- Helper method for punch hole over file, deallocate blocks ---
+// INPUT:   hFile = handle of opened file
+//          size = size of range to deallocate from file start, bytes
+// OUTPUT:  status, 0=OK, otherwise error
+// Note FSCTL_SET_ZERO_DATA deallocates blocks only for sparse files,
+// means FALLOC_FL_PUNCH_HOLE, so file marked sparse first.
+//---
+static int punchFile( HANDLE hFile, size_t size )
+    {
+    DWORD bytesReturned = 0;
+    FILE_ZERO_DATA_INFORMATION zeroInfo;
+    if ( DeviceIoControl( hFile, FSCTL_SET_SPARSE, NULL, 0, NULL, 0, &bytesReturned, NULL ) == 0 ) return 1;
+    zeroInfo.FileOffset.QuadPart = 0;
+    zeroInfo.BeyondFinalZero.QuadPart = size;
+    if ( DeviceIoControl( hFile, FSCTL_SET_ZERO_DATA, &zeroInfo, sizeof(zeroInfo), NULL, 0, &bytesReturned, NULL ) == 0 ) return 1;
+    return 0;
+    }
+
+//--- Helper method for compare doubles, callback for qsort ---
+static int compareDouble( const void* a, const void* b )
+    {
+    double x = *(const double *) a;
+    double y = *(const double *) b;
+    return ( x > y ) - ( x < y );
+    }
+
+//--- Helper method for calculate median of large array, for per-fault latencies ---
+// INPUT:   statArray[] = array of results, reordered by this method
+//          statCount = number of actual results in the array
+// OUTPUT:  median value
+// Note calculateStatistics() uses bubble sort, good for repeats but not for pages count.
+//---
+static double calculateMedian( double statArray[], size_t statCount )
+    {
+    qsort( statArray, statCount, sizeof(double), compareDouble );
+    if ( ( statCount % 2 ) == 0 )
+        {
+        return ( statArray[statCount/2 - 1] + statArray[statCount/2] ) / 2.0;
+        }
+    return statArray[statCount/2];
+    }
+
+//--- Helper method for view size: file part from view offset up to end of file ---
+// INPUT:   ctx = benchmark context
+// OUTPUT:  view size, bytes
+//---
+static size_t viewSize( MMB_CONTEXT* ctx )
+    {
+    return ctx->fileSize - ctx->viewOffset;
+    }
+
+//--- Helper method for walked size: view part from walk start up to end of view ---
+// INPUT:   ctx = benchmark context
+// OUTPUT:  walked size, bytes
+//---
+static size_t walkSize( MMB_CONTEXT* ctx )
+    {
+    return viewSize( ctx ) - ctx->viewAlign;
+    }
+
+//--- Helper method for number of walked pages, one touch per step, partial last step counted ---
+// INPUT:   ctx = benchmark context
+// OUTPUT:  number of touches per walk over view
+//---
+static size_t walkPages( MMB_CONTEXT* ctx )
+    {
+    return ( walkSize( ctx ) + ctx->walkStep - 1 ) / ctx->walkStep;
+    }
+
+//--- Helper method for walk start: view start, displaced by align option ---
+// INPUT:   ctx = benchmark context, view mapped
+// OUTPUT:  pointer to first walked byte
+//---
+static char* walkBase( MMB_CONTEXT* ctx )
+    {
+    return (char *) ctx->mapPointer + ctx->viewAlign;
+    }
+
+//--- Helper method for straddle phase probe group size ---
+// INPUT:   ctx = benchmark context
+// OUTPUT:  group size, bytes, STRADDLE_GROUP fault-around windows, window is at least one page
+//---
+static size_t straddleGroup( MMB_CONTEXT* ctx )
+    {
+    return ( ctx->pageSize > STRADDLE_WINDOW ? ctx->pageSize : STRADDLE_WINDOW ) * STRADDLE_GROUP;
+    }
+
+//--- Helper method for open file, create mapping object and map view to address space ---
+// INPUT:   ctx = benchmark context
+//          createMode = CreateFile creation mode, CREATE_ALWAYS for new file or OPEN_ALWAYS for re-open
+//          prepareMode = file preparation before mapping: PREPARE_NONE, PREPARE_ALLOC, PREPARE_PUNCH
+//          viewMode = mapping mode: MMB_MAPPING_SHARED, MMB_MAPPING_PRIVATE, MMB_MAPPING_READONLY
+// OUTPUT:  status, MMB_OK or MMB_ERROR with context errorText
+//          update context fileHandle, mapHandle, sectionHandle, mapPointer
+// View maps file from view offset up to end of file, offset is multiple of allocation granularity.
+//---
+static int openView( MMB_CONTEXT* ctx, DWORD createMode, int prepareMode, int viewMode )
+    {
+    DWORD mapSizeHigh = 0;    // high 32 bits of mapping size
+    DWORD mapSizeLow = 0;     // low 32 bits of mapping size
+    DWORD offsetHigh = 0;     // high 32 bits of view offset
+    DWORD offsetLow = 0;      // low 32 bits of view offset
+    convert64 ( ctx->fileSize, &mapSizeLow, &mapSizeHigh );
+    convert64 ( ctx->viewOffset, &offsetLow, &offsetHigh );
+    //--- Anonymous memory, no file and no mapping object ---
+    if ( ctx->targetMode == MMB_TARGET_ANON )
+        {
+        if ( ctx->mapPointer == NULL )
+            {
+            ctx->mapPointer = VirtualAlloc( NULL, viewSize( ctx ), MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE );
+            if ( ctx->mapPointer == NULL ) return setError( ctx, MMB_ERROR, "Error allocate memory" );
+            ctx->targetExists = 1;
+            }
+        ctx->viewOpen = 1;
+        return MMB_OK;
+        }
+    //--- Pagefile-backed section, created once and kept open up to delete ---
+    if ( ctx->targetMode == MMB_TARGET_MEMFD )
+        {
+        if ( ctx->sectionHandle == NULL )
+            {
+            ctx->sectionHandle = CreateFileMapping( INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE | SEC_COMMIT,
+                                                    mapSizeHigh, mapSizeLow, NULL );
+            if ( ctx->sectionHandle == NULL ) return setError( ctx, MMB_ERROR, "Error create section" );
+            ctx->targetExists = 1;
+            }
+        ctx->mapPointer = MapViewOfFile( ctx->sectionHandle, viewAccesses[viewMode], offsetHigh, offsetLow, viewSize( ctx ) );
+        if ( ctx->mapPointer == NULL ) return setError( ctx, MMB_ERROR, "Error create view" );
+        ctx->viewOpen = 1;
+        return MMB_OK;
+        }
+    //--- Create or re-open file ---
+    ctx->fileHandle = CreateFile( ctx->filePath, fileAccess, fileShare, NULL, createMode, ctx->fileFlags, NULL );
+    if ( ( ctx->fileHandle == NULL ) || ( ctx->fileHandle == INVALID_HANDLE_VALUE ) )
+        {
+        ctx->fileHandle = NULL;
+        return setError( ctx, MMB_ERROR, "Error open file" );
+        }
+    ctx->targetExists = 1;
+    //--- Prepare file blocks: sparse, preallocated or prezeroed file, or punch hole ---
+    if ( ( prepareMode == PREPARE_ALLOC ) && ( allocateFile( ctx->fileHandle, ctx->allocMode, ctx->fileSize ) != 0 ) )
+        {
+        return setError( ctx, MMB_ERROR, "Error allocate file" );
+        }
+    if ( ( prepareMode == PREPARE_PUNCH ) && ( punchFile( ctx->fileHandle, ctx->fileSize ) != 0 ) )
+        {
+        return setError( ctx, MMB_ERROR, "Error punch hole" );
+        }
+    //--- Create mapping object for file ---
+    ctx->mapHandle = CreateFileMapping( ctx->fileHandle, NULL, mapProtects[viewMode], mapSizeHigh, mapSizeLow, NULL );
+    if ( ctx->mapHandle == NULL ) return setError( ctx, MMB_ERROR, "Error create mapping" );
+    //--- Mapping created object to address space ---
+    ctx->mapPointer = MapViewOfFile( ctx->mapHandle, viewAccesses[viewMode], offsetHigh, offsetLow, viewSize( ctx ) );
+    if ( ctx->mapPointer == NULL ) return setError( ctx, MMB_ERROR, "Error create view" );
+    ctx->viewOpen = 1;
+    return MMB_OK;
+    }
+
+//--- Helper method for close mapping object and file, unmap view of file ---
+// INPUT:   ctx = benchmark context
+// OUTPUT:  status, MMB_OK or MMB_ERROR with context errorText
+// Note objects partially opened by failed openView also closed, for teardown after errors.
+//---
+static int closeView( MMB_CONTEXT* ctx )
+    {
+    int status = MMB_OK;
+    //--- Anonymous memory, kept up to delete, so read phase walks data of write phase ---
+    if ( ctx->targetMode == MMB_TARGET_ANON )
+        {
+        ctx->viewOpen = 0;
+        return status;
+        }
+    //--- File, close mapping and file, section kept up to delete ---
+    if ( ( ctx->mapHandle != NULL ) && ( CloseHandle( ctx->mapHandle ) == 0 ) )
+        {
+        status = setError( ctx, MMB_ERROR, "Error close mapping" );
+        }
+    if ( ( ctx->fileHandle != NULL ) && ( CloseHandle( ctx->fileHandle ) == 0 ) )
+        {
+        status = setError( ctx, MMB_ERROR, "Error close file" );
+        }
+    //--- Unmap view ---
+    if ( ( ctx->mapPointer != NULL ) && ( UnmapViewOfFile( ctx->mapPointer ) == 0 ) )
+        {
+        status = setError( ctx, MMB_ERROR, "Error unmap file" );
+        }
+    ctx->mapHandle = NULL;
+    ctx->fileHandle = NULL;
+    ctx->mapPointer = NULL;
+    ctx->viewOpen = 0;
+    return status;
+    }
+
+//--- Helper method for flush view, means write operation for file targets ---
+// INPUT:   ctx = benchmark context
+// OUTPUT:  status, nonzero=OK, 0=error, same as FlushViewOfFile
+//---
+static int flushView( MMB_CONTEXT* ctx )
+    {
+    if ( ctx->targetMode == MMB_TARGET_ANON ) return 1;   // no backing store, nothing to flush
+    return FlushViewOfFile( ctx->mapPointer, viewSize( ctx ) );
+    }
+
+//--- Helper method for start write back of one chunk of view, chunk size from context, last chunk can be shorter ---
+// Linux: sync_file_range with SYNC_FILE_RANGE_WRITE, write back started and not waited,
+// msync MS_ASYNC is no operation since kernel 2.6.19 so not used.
+// Windows: no write back kick-off for mapped view, FlushViewOfFile of chunk range
+// writes it and waits, pipelined mode hides it by background thread.
+// INPUT:   ctx = benchmark context
+//          index = chunk number
+// OUTPUT:  status, nonzero=OK, 0=error, same as FlushViewOfFile
+//---
+static int flushChunk( MMB_CONTEXT* ctx, size_t index )
+    {
+    size_t offset = index * ctx->flushChunk;
+    size_t length = viewSize( ctx ) - offset;
+    if ( length > ctx->flushChunk ) length = ctx->flushChunk;
+#if defined(_WIN32)
+    return FlushViewOfFile( (char*)ctx->mapPointer + offset, length );
+#else
+    return FlushFileRange( ctx->fileHandle, ctx->viewOffset + offset, length );
+#endif
+    }
+
+//--- Pipelined flush thread: flush chunks in the fill order, wait for each chunk filled ---
+// INPUT:   parm = pointer to FLUSHER structure
+// OUTPUT:  0
+//---
+static DWORD WINAPI flusherThread( LPVOID parm )
+    {
+    FLUSHER* flusher = (FLUSHER*)parm;
+    size_t i;
+    for ( i=0; i<flusher->chunks; i++ )
+        {
+        WaitForSingleObject( flusher->ready, INFINITE );
+        if ( flushChunk( flusher->ctx, i ) == 0 ) flusher->status = 1;
+        }
+    return 0;
+    }
+
+//--- Helper method for fill view and write it back up to durable data, all flush modes ---
+// Sync: fill all view, then flush it.
+// Async: foreground thread starts write back of each chunk after fill it.
+// Pipelined: background thread starts write back of chunk N-1 while foreground thread fills chunk N.
+// All modes end with one durable flush: flush of view waits write back of all dirty pages,
+// then FlushFileBuffers writes metadata and device cache, so modes timed over same interval.
+// INPUT:   ctx = benchmark context, view mapped
+// OUTPUT:  status, MMB_OK or MMB_ERROR with context errorText
+//---
+static int fillAndFlush( MMB_CONTEXT* ctx )
+    {
+    FLUSHER flusher;
+    HANDLE thread = NULL;
+    size_t chunks = ( viewSize( ctx ) + ctx->flushChunk - 1 ) / ctx->flushChunk;
+    size_t i, offset, length;
+    int status = MMB_OK;
+    if ( ctx->flushMode == MMB_FLUSH_SYNC )
+        {
+        memset( ctx->mapPointer, SET_DATA, viewSize( ctx ) );
+        chunks = 0;
+        }
+    else if ( ctx->flushMode == MMB_FLUSH_PIPELINED )
+        {
+        flusher.ctx = ctx;
+        flusher.chunks = chunks;
+        flusher.status = 0;
+        flusher.ready = CreateSemaphore( NULL, 0, (LONG)chunks, NULL );
+        if ( flusher.ready == NULL ) return setError( ctx, MMB_ERROR, "Error create semaphore" );
+        thread = CreateThread( NULL, 0, flusherThread, &flusher, 0, NULL );
+        if ( thread == NULL )
+            {
+            CloseHandle( flusher.ready );
+            return setError( ctx, MMB_ERROR, "Error create flush thread" );
+            }
+        }
+    for ( i=0; i<chunks; i++ )
+        {
+        offset = i * ctx->flushChunk;
+        length = viewSize( ctx ) - offset;
+        if ( length > ctx->flushChunk ) length = ctx->flushChunk;
+        memset( (char*)ctx->mapPointer + offset, SET_DATA, length );
+        if ( thread != NULL )
+            {
+            ReleaseSemaphore( flusher.ready, 1, NULL );
+            }
+        else if ( flushChunk( ctx, i ) == 0 )
+            {
+            return setError( ctx, MMB_ERROR, "Error flush file" );
+            }
+        }
+    if ( thread != NULL )
+        {
+        WaitForSingleObject( thread, INFINITE );
+        CloseHandle( thread );
+        CloseHandle( flusher.ready );
+        if ( flusher.status != 0 ) return setError( ctx, MMB_ERROR, "Error flush file" );
+        }
+    if ( flushView( ctx ) == 0 ) return setError( ctx, MMB_ERROR, "Error flush file" );
+    if ( ( ctx->fileHandle != NULL ) && ( FlushFileBuffers( ctx->fileHandle ) == 0 ) )
+        {
+        status = setError( ctx, MMB_ERROR, "Error flush file buffers" );
+        }
+    return status;
+    }
+
+//--- Helper method for free locked balloon ---
+// INPUT:   ctx = benchmark context
+// OUTPUT:  status, MMB_OK or MMB_ERROR with context errorText
+//---
+static int freeBalloon( MMB_CONTEXT* ctx )
+    {
+    int status = MMB_OK;
+    if ( ctx->balloonPointer != NULL )
+        {
+        VirtualUnlock( ctx->balloonPointer, ctx->balloonSize );    // error if not locked, ignored
+        if ( VirtualFree( ctx->balloonPointer, 0, MEM_RELEASE ) == 0 ) status = setError( ctx, MMB_ERROR, "Error free balloon" );
+        ctx->balloonPointer = NULL;
+        }
+    return status;
+    }
+
+//--- Helper method for apply memory pressure: working set limit and locked balloon ---
+// Windows has no memory cgroups, working set of the process limited by hard maximum,
+// pages trimmed from working set go to standby list and refault from it or from file.
+// Balloon is locked memory, it reduces physical memory available for file cache.
+// Working set size saved at first call, next calls replace balloon and limit, for memory sweep.
+// Working set limits are process-wide, first call takes them for this context, other context refused.
+// INPUT:   ctx = benchmark context
+//          pass = number of pass, selects balloon and limit, see mmb_pressure, mmb_limit
+// OUTPUT:  status, MMB_OK or MMB_ERROR with context errorText
+//---
+static int applyPressure( MMB_CONTEXT* ctx, int pass )
+    {
+    SIZE_T minimum = 0, maximum = 0;
+    DWORD flags = 0;
+    size_t pressure = mmb_pressure( ctx, pass );
+    size_t limit = mmb_limit( ctx, pass );
+    int status = MMB_OK;
+    if ( ( pressure == 0 ) && ( limit == 0 ) ) return MMB_OK;
+    if ( ctx->limitsSet == 0 )
+        {
+        if ( InterlockedCompareExchangePointer( (void**) &limitsOwner, ctx, NULL ) != NULL )
+            {
+            return setError( ctx, MMB_ERROR, "Memory pressure and limit are process-wide, already set by other context" );
+            }
+        if ( GetProcessWorkingSetSize( GetCurrentProcess(), &minimum, &maximum ) == 0 )
+            {
+            limitsOwner = NULL;
+            return setError( ctx, MMB_ERROR, "Error get working set size" );
+            }
+        ctx->savedMinimum = minimum;
+        ctx->savedMaximum = maximum;
+        }
+    status = freeBalloon( ctx );
+    if ( status != MMB_OK ) return status;
+    minimum = ctx->savedMinimum;
+    maximum = ctx->savedMaximum;
+    if ( pressure != 0 )
+        {
+        minimum = pressure + BALLOON_MARGIN;    // locked pages must fit in working set minimum
+        if ( maximum < minimum + BALLOON_MARGIN ) maximum = minimum + BALLOON_MARGIN;
+        }
+    if ( limit != 0 )
+        {
+        if ( minimum >= limit ) minimum = limit / 2;
+        maximum = limit;
+        flags = QUOTA_LIMITS_HARDWS_MIN_DISABLE | QUOTA_LIMITS_HARDWS_MAX_ENABLE;
+        }
+    if ( SetProcessWorkingSetSizeEx( GetCurrentProcess(), minimum, maximum, flags ) == 0 )
+        {
+        if ( ctx->limitsSet == 0 ) limitsOwner = NULL;
+#if !defined(_WIN32)
+        if ( limit != 0 )
+            {
+            return setError( ctx, MMB_ERROR, "Error set working set size, limit requires delegated cgroup v2 with no other processes" );
+            }
+#endif
+        return setError( ctx, MMB_ERROR, "Error set working set size" );
+        }
+    ctx->limitsSet = 1;
+    if ( pressure == 0 ) return MMB_OK;
+    ctx->balloonPointer = VirtualAlloc( NULL, pressure, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE );
+    if ( ctx->balloonPointer == NULL ) return setError( ctx, MMB_ERROR, "Error allocate balloon" );
+    ctx->balloonSize = pressure;
+    memset( ctx->balloonPointer, 0, pressure );
+    if ( VirtualLock( ctx->balloonPointer, pressure ) == 0 ) return setError( ctx, MMB_ERROR, "Error lock balloon" );
+    return MMB_OK;
+    }
+
+//--- Helper method for release memory pressure: free balloon, restore working set size ---
+// INPUT:   ctx = benchmark context
+// OUTPUT:  status, MMB_OK or MMB_ERROR with context errorText
+//---
+static int releasePressure( MMB_CONTEXT* ctx )
+    {
+    int status = freeBalloon( ctx );
+    if ( ctx->limitsSet )
+        {
+        if ( SetProcessWorkingSetSizeEx( GetCurrentProcess(), ctx->savedMinimum, ctx->savedMaximum,
+                                         QUOTA_LIMITS_HARDWS_MIN_DISABLE | QUOTA_LIMITS_HARDWS_MAX_DISABLE ) == 0 )
+            {
+            status = setError( ctx, MMB_ERROR, "Error restore working set size" );
+            }
+        ctx->limitsSet = 0;
+        limitsOwner = NULL;
+        }
+    return status;
+    }
+
+//--- Helper method for open-loop wait up to intended start ---
+// Sleep can oversleep by one timer tick, about 15.6 ms at default Windows timer resolution,
+// so sleeps only while more than SCHEDULE_SPIN_MS remain, up to SCHEDULE_SPIN_MS before
+// intended start, and spins rest of wait: oversleep not charged to scheduled latency.
+// INPUT:   intended = QueryPerformanceCounter value of intended start
+//          frequency = QueryPerformanceFrequency value
+// OUTPUT:  counter value at wait end, not below intended
+//---
+static long long waitUntil( long long intended, LARGE_INTEGER* frequency )
+    {
+    LARGE_INTEGER now;
+    long long remainingMs = 0;
+    QueryPerformanceCounter( &now );
+    while ( now.QuadPart < intended )
+        {
+        remainingMs = ( intended - now.QuadPart ) * 1000 / frequency->QuadPart;
+        if ( remainingMs > SCHEDULE_SPIN_MS )
+            Sleep( (DWORD)( remainingMs - SCHEDULE_SPIN_MS ) );
+        else
+            YieldProcessor();
+        QueryPerformanceCounter( &now );
+        }
+    return now.QuadPart;
+    }
+
+//--- Helper method for open-loop page walk: each page touched on fixed schedule ---
+// Touch number i intended at start + i / rate, latency measured from intended start,
+// so touches delayed by slow faults include queueing time, no coordinated omission.
+// Achieved rate is completed touches divided by time from start up to last touch done,
+// below offered rate when faults are slower than schedule.
+// INPUT:   ctx = benchmark context, view mapped
+//          rate = offered touches per second
+//          latencies = array for per-touch latency, microseconds, one entry per page
+// OUTPUT:  achieved rate, touches per second
+//---
+static double scheduledWalk( MMB_CONTEXT* ctx, int rate, double latencies[] )
+    {
+    size_t walkCount = 0;
+    size_t walkLimit = walkPages( ctx );
+    volatile char walkData = 0;
+    char* walkPointer = walkBase( ctx );
+    LARGE_INTEGER start, now, frequency;
+    long long intended = 0;
+    QueryPerformanceFrequency( &frequency );
+    QueryPerformanceCounter( &start );
+    for ( walkCount=0; walkCount<walkLimit; walkCount++ )
+        {
+        intended = start.QuadPart + (long long)( (double)walkCount * frequency.QuadPart / rate );
+        waitUntil( intended, &frequency );
+        walkData = *walkPointer;
+        QueryPerformanceCounter( &now );
+        latencies[walkCount] = (double)( now.QuadPart - intended ) * SECONDS_TO_MICROSECONDS / frequency.QuadPart;
+        walkPointer += ctx->walkStep;
+        }
+    if ( now.QuadPart <= start.QuadPart ) return 0.0;
+    return (double)walkLimit * frequency.QuadPart / ( now.QuadPart - start.QuadPart );
+    }
+
+//--- Helper method for delete target: file, or pagefile-backed section ---
+// INPUT:   ctx = benchmark context
+// OUTPUT:  status, MMB_OK or MMB_ERROR with context errorText
+//---
+static int deleteTarget( MMB_CONTEXT* ctx )
+    {
+    ctx->targetExists = 0;
+    if ( ctx->targetMode == MMB_TARGET_ANON )
+        {
+        int status = ( ctx->mapPointer == NULL ) || VirtualFree( ctx->mapPointer, 0, MEM_RELEASE );
+        ctx->mapPointer = NULL;
+        if ( status == 0 ) return setError( ctx, MMB_ERROR, "Error release memory" );
+        return MMB_OK;
+        }
+    if ( ctx->targetMode == MMB_TARGET_MEMFD )
+        {
+        int status = CloseHandle( ctx->sectionHandle );
+        ctx->sectionHandle = NULL;
+        if ( status == 0 ) return setError( ctx, MMB_ERROR, "Error close section" );
+        return MMB_OK;
+        }
+    if ( DeleteFile( ctx->filePath ) == 0 ) return setError( ctx, MMB_ERROR, "Error delete file" );
+    return MMB_OK;
+    }
+
+//--- Helper method for check path located on DAX volume, for pmem-dir target ---
+// INPUT:   path = file path
+// OUTPUT:  1 = DAX volume, 0 = not DAX volume or volume not detected
+//---
+static int checkDaxVolume( char* path )
+    {
+    char volumePath[MAX_PATH];
+    DWORD volumeFlags = 0;
+    if ( GetVolumePathName( path, volumePath, MAX_PATH ) == 0 ) return 0;
+    if ( GetVolumeInformation( volumePath, NULL, 0, NULL, NULL, &volumeFlags, NULL, 0 ) == 0 ) return 0;
+    return ( volumeFlags & FILE_DAX_VOLUME ) != 0;
+    }
+
+//---------- Library entry points ----------------------------------------------
+
+//--- Initialize context: options defaults, system parameters, no objects opened ---
+// INPUT:   ctx = benchmark context
+// Page size and view offset granularity detected at run time, page walk step default is page size.
+//---
+void mmb_init( MMB_CONTEXT* ctx )
+    {
+    SYSTEM_INFO systemInfo;
+    int i = 0;
+    memset( ctx, 0, sizeof(MMB_CONTEXT) );
+    GetSystemInfo( &systemInfo );
+    ctx->pageSize    = systemInfo.dwPageSize;
+    ctx->granularity = systemInfo.dwAllocationGranularity;
+    ctx->filePath    = FILE_PATH;
+    ctx->fileSize    = FILE_SIZE;
+    ctx->writeDelay  = WRITE_DELAY;
+    ctx->readDelay   = READ_DELAY;
+    ctx->repeats     = MEASURE_REPEATS;
+    ctx->allocMode   = ALLOC_MODE;
+    ctx->punchMode   = PUNCH_MODE;
+    ctx->reuseMode   = REUSE_MODE;
+    ctx->mappingMode = MAPPING_MODE;
+    ctx->targetMode  = TARGET_MODE;
+    ctx->replayMode  = REPLAY_MODE;
+    ctx->countersMode = COUNTERS_MODE;
+    ctx->flushMode   = FLUSH_MODE;
+    ctx->flushChunk  = FLUSH_CHUNK;
+    ctx->pressureSize = PRESSURE_SIZE;
+    ctx->memoryLimit = MEMORY_LIMIT;
+    ctx->touchMode   = TOUCH_MODE;
+    ctx->touchRate   = TOUCH_RATE;
+    ctx->sweepMode   = SWEEP_MODE;
+    ctx->fileMode    = FILE_MODE;
+    ctx->firstPages  = FIRST_PAGES;
+    ctx->cacheMode   = CACHE_MODE;
+    ctx->walkStep    = ctx->pageSize;
+    ctx->viewOffset  = VIEW_OFFSET;
+    ctx->viewAlign   = VIEW_ALIGN;
+    ctx->straddleMode = STRADDLE_MODE;
+    for ( i=0; i<MMB_COUNTERS_COUNT; i++ ) ctx->perfEvents[i] = -1;
+    }
+
+//--- Check start parameters validity and compatibility ---
+// INPUT:   ctx = benchmark context with options
+// OUTPUT:  status, MMB_OK or MMB_BAD_PARAMETER with context errorText
+// For existing file mode file size option replaced by size of existing file.
+//---
+int mmb_check( MMB_CONTEXT* ctx )
+    {
+    char s1[PRINT_LIMIT];
+    char s2[PRINT_LIMIT];
+    int i = 0;
+    if ( ctx->fileMode == MMB_MODE_EXISTING )
+        {
+        WIN32_FILE_ATTRIBUTE_DATA fileData;
+        if ( GetFileAttributesEx( ctx->filePath, GetFileExInfoStandard, &fileData ) == 0 )
+            {
+            return setError( ctx, MMB_BAD_PARAMETER, "Existing file %s not found", ctx->filePath );
+            }
+        ctx->fileSize = ( (unsigned long long)fileData.nFileSizeHigh << 32 ) | fileData.nFileSizeLow;
+        }
+    if ( ( ctx->fileSize < FILE_SIZE_MIN ) | ( ctx->fileSize > FILE_SIZE_MAX ) )
+        {
+        scratchMemorySize( s1, FILE_SIZE_MIN );
+        scratchMemorySize( s2, FILE_SIZE_MAX );
+        return setError( ctx, MMB_BAD_PARAMETER, "file size must be from %s to %s", s1, s2 );
+        }
+    //--- Created file size rejected, not rounded, if not page multiple: partial last page means walks and MBPS over other size ---
+    if ( ( ctx->fileMode == MMB_MODE_CREATE ) && ( ctx->fileSize % ctx->pageSize != 0 ) )
+        {
+        return setError( ctx, MMB_BAD_PARAMETER, "File size must be multiple of page size %d bytes", (int)ctx->pageSize );
+        }
+    if ( ( ctx->writeDelay < DELAY_MIN ) | ( ctx->writeDelay > DELAY_MAX ) )
+        {
+        return setError( ctx, MMB_BAD_PARAMETER, "Write delay must be from %d to %d milliseconds", DELAY_MIN, DELAY_MAX );
+        }
+    if ( ( ctx->readDelay < DELAY_MIN ) | ( ctx->readDelay > DELAY_MAX ) )
+        {
+        return setError( ctx, MMB_BAD_PARAMETER, "Read delay must be from %d to %d milliseconds", DELAY_MIN, DELAY_MAX );
+        }
+    if ( ( ctx->repeats < REPEATS_MIN ) | ( ctx->repeats > MMB_REPEATS_MAX ) )
+        {
+        return setError( ctx, MMB_BAD_PARAMETER, "Repeats must be from %d to %d times", REPEATS_MIN, MMB_REPEATS_MAX );
+        }
+    if ( ( ctx->reuseMode < REUSE_MIN ) | ( ctx->reuseMode > REUSE_MAX ) )
+        {
+        return setError( ctx, MMB_BAD_PARAMETER, "Reuse must be %s, %s or %s",
+                         mmbReuseNames[MMB_REUSE_NONE], mmbReuseNames[MMB_REUSE_FILE], mmbReuseNames[MMB_REUSE_VIEW] );
+        }
+    if ( ( ctx->mappingMode != MMB_MAPPING_SHARED ) & ( ctx->reuseMode == MMB_REUSE_VIEW ) )
+        {
+        return setError( ctx, MMB_BAD_PARAMETER, "Mapping %s not compatible with reuse=%s, write phase view is shared",
+                         mmbMappingNames[ctx->mappingMode], mmbReuseNames[MMB_REUSE_VIEW] );
+        }
+    if ( ( ctx->punchMode != 0 ) & ( ctx->reuseMode != MMB_REUSE_NONE ) )
+        {
+        return setError( ctx, MMB_BAD_PARAMETER,
+                         "Punch-hole phase requires reuse=%s, punched file reused by next pass means allocation, not overwrite in place",
+                         mmbReuseNames[MMB_REUSE_NONE] );
+        }
+    if ( ( ( ctx->targetMode == MMB_TARGET_ANON ) | ( ctx->targetMode == MMB_TARGET_MEMFD ) ) &
+         ( ( ctx->allocMode != MMB_ALLOC_EXTEND ) | ( ctx->punchMode != 0 ) ) )
+        {
+        return setError( ctx, MMB_BAD_PARAMETER, "Target %s has no file blocks, alloc and punch not supported",
+                         mmbTargetNames[ctx->targetMode] );
+        }
+    if ( ( ctx->targetMode == MMB_TARGET_ANON ) & ( ctx->mappingMode != MMB_MAPPING_SHARED ) )
+        {
+        return setError( ctx, MMB_BAD_PARAMETER, "Target %s supports shared mapping only", mmbTargetNames[ctx->targetMode] );
+        }
+    if ( ( ctx->flushChunk < ctx->pageSize ) | ( ctx->flushChunk > CHUNK_MAX ) | ( ctx->flushChunk % ctx->pageSize != 0 ) )
+        {
+        scratchMemorySize( s1, ctx->pageSize );
+        scratchMemorySize( s2, CHUNK_MAX );
+        return setError( ctx, MMB_BAD_PARAMETER, "Flush chunk must be from page size %s to %s, multiple of page size",
+                         s1, s2 );
+        }
+    if ( ( ctx->walkStep < ctx->pageSize ) | ( ctx->walkStep > STEP_MAX ) )
+        {
+        scratchMemorySize( s1, ctx->pageSize );
+        scratchMemorySize( s2, STEP_MAX );
+        return setError( ctx, MMB_BAD_PARAMETER, "Page walk step must be from page size %s to %s", s1, s2 );
+        }
+    if ( ( ctx->viewOffset % ctx->granularity != 0 ) | ( ctx->viewOffset >= ctx->fileSize ) )
+        {
+        return setError( ctx, MMB_BAD_PARAMETER, "View offset must be below file size, multiple of allocation granularity %d bytes",
+                         (int)ctx->granularity );
+        }
+    if ( ( ctx->viewAlign >= ctx->pageSize ) | ( ctx->viewAlign >= viewSize( ctx ) ) )
+        {
+        return setError( ctx, MMB_BAD_PARAMETER, "Align must be below page size %d bytes and below view size", (int)ctx->pageSize );
+        }
+    if ( ( ( ctx->viewOffset != 0 ) | ( ctx->viewAlign != 0 ) ) & ( ( ctx->trace != NULL ) | ( ctx->fileMode != MMB_MODE_CREATE ) ) )
+        {
+        return setError( ctx, MMB_BAD_PARAMETER, "View offset and align not compatible with trace replay and mode %s",
+                         mmbModeNames[MMB_MODE_EXISTING] );
+        }
+    if ( ( ctx->straddleMode != 0 ) &
+         ( ( ctx->trace != NULL ) | ( ctx->fileMode != MMB_MODE_CREATE ) | ( ctx->reuseMode == MMB_REUSE_VIEW ) ) )
+        {
+        return setError( ctx, MMB_BAD_PARAMETER, "Straddle phase not compatible with trace replay, mode %s and reuse=%s",
+                         mmbModeNames[MMB_MODE_EXISTING], mmbReuseNames[MMB_REUSE_VIEW] );
+        }
+    if ( ( ctx->straddleMode != 0 ) & ( viewSize( ctx ) < straddleGroup( ctx ) ) )
+        {
+        scratchMemorySize( s1, straddleGroup( ctx ) );
+        return setError( ctx, MMB_BAD_PARAMETER, "Straddle phase requires view size at least %s", s1 );
+        }
+    if ( ctx->pressureSize > PRESSURE_MAX )
+        {
+        scratchMemorySize( s1, PRESSURE_MAX );
+        return setError( ctx, MMB_BAD_PARAMETER, "Pressure balloon must be up to %s", s1 );
+        }
+    if ( ( ctx->memoryLimit != 0 ) & ( ( ctx->memoryLimit < LIMIT_MIN ) | ( ctx->memoryLimit > LIMIT_MAX ) ) )
+        {
+        scratchMemorySize( s1, LIMIT_MIN );
+        scratchMemorySize( s2, LIMIT_MAX );
+        return setError( ctx, MMB_BAD_PARAMETER, "Memory limit must be 0 or from %s to %s", s1, s2 );
+        }
+    for ( i=0; i<ctx->repeats; i++ )
+        {
+        size_t pressure = mmb_pressure( ctx, i );
+        size_t limit = mmb_limit( ctx, i );
+        if ( ( limit != 0 ) & ( pressure != 0 ) & ( pressure + 2 * BALLOON_MARGIN > limit ) )
+            {
+            scratchMemorySize( s1, 2 * BALLOON_MARGIN );
+            return setError( ctx, MMB_BAD_PARAMETER, "Memory limit must exceed pressure balloon by %s, pass %d", s1, i+1 );
+            }
+        }
+    if ( ( ctx->touchRate < RATE_MIN ) | ( ctx->touchRate > RATE_MAX ) )
+        {
+        return setError( ctx, MMB_BAD_PARAMETER, "Rate must be from %d to %d pages per second", RATE_MIN, RATE_MAX );
+        }
+    if ( ( ctx->touchMode != 0 ) & ( ctx->mappingMode != MMB_MAPPING_SHARED ) )
+        {
+        return setError( ctx, MMB_BAD_PARAMETER, "Touch option is for mapping %s, mapping %s %s",
+                         mmbMappingNames[MMB_MAPPING_SHARED], mmbMappingNames[ctx->mappingMode],
+                         ctx->mappingMode == MMB_MAPPING_PRIVATE ? "always touched" : "not writable" );
+        }
+    if ( ( ctx->sweepMode == MMB_SWEEP_RATE ) & ( ctx->touchRate == 0 ) )
+        {
+        return setError( ctx, MMB_BAD_PARAMETER, "Sweep %s requires rate", mmbSweepNames[MMB_SWEEP_RATE] );
+        }
+    if ( ( ctx->sweepMode == MMB_SWEEP_MEMORY ) & ( ctx->pressureSize == 0 ) & ( ctx->memoryLimit == 0 ) )
+        {
+        return setError( ctx, MMB_BAD_PARAMETER, "Sweep %s requires pressure or limit", mmbSweepNames[MMB_SWEEP_MEMORY] );
+        }
+    if ( ( ctx->sweepMode == MMB_SWEEP_MEMORY ) & ( ( ctx->trace != NULL ) | ( ctx->fileMode != MMB_MODE_CREATE ) ) )
+        {
+        return setError( ctx, MMB_BAD_PARAMETER, "Sweep %s not compatible with trace replay and mode %s",
+                         mmbSweepNames[MMB_SWEEP_MEMORY], mmbModeNames[MMB_MODE_EXISTING] );
+        }
+    if ( ( ctx->touchRate != 0 ) & ( ctx->trace != NULL ) )
+        {
+        return setError( ctx, MMB_BAD_PARAMETER, "Rate not compatible with trace replay, replay has recorded schedule" );
+        }
+    if ( ( ctx->firstPages < FIRST_MIN ) | ( ctx->firstPages > FIRST_MAX ) )
+        {
+        return setError( ctx, MMB_BAD_PARAMETER, "First pages must be from %d to %d", FIRST_MIN, FIRST_MAX );
+        }
+    if ( ( ctx->fileMode == MMB_MODE_EXISTING ) &
+         ( ( ctx->targetMode != MMB_TARGET_FILE ) | ( ctx->trace != NULL ) | ( ctx->punchMode != 0 ) |
+           ( ctx->reuseMode != MMB_REUSE_NONE ) | ( ctx->touchRate != 0 ) ) )
+        {
+        return setError( ctx, MMB_BAD_PARAMETER,
+                         "Mode %s requires file target, without trace, punch-hole phase, reuse and rate",
+                         mmbModeNames[ctx->fileMode] );
+        }
+    if ( ( ctx->hotset != NULL ) && ( ctx->fileMode != MMB_MODE_EXISTING ) )
+        {
+        return setError( ctx, MMB_BAD_PARAMETER, "Hot set requires mode %s", mmbModeNames[MMB_MODE_EXISTING] );
+        }
+#if defined(_WIN32)
+    //--- Unbuffered open does not evict file pages from standby list, purge of standby list requires privilege ---
+    if ( ctx->cacheMode == MMB_CACHE_COLD )
+        {
+        return setError( ctx, MMB_BAD_PARAMETER, "Cache %s not supported on Windows, file pages kept in standby list, "
+                         "reboot for cold start", mmbCacheNames[MMB_CACHE_COLD] );
+        }
+#endif
+    if ( ( ctx->hotset != NULL ) && ( ctx->hotset->maximum >= ctx->fileSize ) )
+        {
+        return setError( ctx, MMB_BAD_PARAMETER, "Hot set offset 0x%llX beyond end of file",
+                         (unsigned long long)ctx->hotset->maximum );
+        }
+    if ( ( ( ctx->targetMode == MMB_TARGET_ANON ) | ( ctx->targetMode == MMB_TARGET_MEMFD ) ) & ( ctx->flushMode != MMB_FLUSH_SYNC ) )
+        {
+        return setError( ctx, MMB_BAD_PARAMETER, "Target %s has no backing store, flush %s not supported",
+                         mmbTargetNames[ctx->targetMode], mmbFlushNames[ctx->flushMode] );
+        }
+    if ( ( ctx->targetMode == MMB_TARGET_PMEM ) && ( checkDaxVolume( ctx->filePath ) == 0 ) )
+        {
+        return setError( ctx, MMB_BAD_PARAMETER, "Target %s requires path on DAX volume", mmbTargetNames[ctx->targetMode] );
+        }
+    if ( ctx->trace != NULL )
+        {
+        if ( ( ctx->mappingMode != MMB_MAPPING_SHARED ) | ( ctx->punchMode != 0 ) )
+            {
+            return setError( ctx, MMB_BAD_PARAMETER, "Trace replay supports shared mapping only, without punch-hole phase" );
+            }
+        if ( ctx->fileSize < ctx->trace->span )
+            {
+            scratchMemorySize( s1, ctx->trace->span );
+            return setError( ctx, MMB_BAD_PARAMETER, "Trace replay requires file size at least %s", s1 );
+            }
+        }
+    return MMB_OK;
+    }
+
+//--- Setup benchmark: check parameters, blank logs, create file once if file reused between passes ---
+// INPUT:   ctx = benchmark context with options
+// OUTPUT:  status, MMB_OK or error status with context errorText
+//---
+int mmb_setup( MMB_CONTEXT* ctx )
+    {
+    int status = mmb_check( ctx );
+    if ( status != MMB_OK ) return status;
+    memset( ctx->logs, 0, sizeof(ctx->logs) );
+    memset( ctx->counters, 0, sizeof(ctx->counters) );
+    ctx->fileFlags = targetFlags[ctx->targetMode];
+#if !defined(_WIN32)
+    PerfEventsClose( ctx->perfEvents );
+    if ( ctx->countersMode != 0 ) PerfEventsOpen( ctx->perfEvents );    // events not opened stay not valid
+#endif
+    status = applyPressure( ctx, 0 );
+    if ( status != MMB_OK ) return status;
+    if ( ( ctx->reuseMode != MMB_REUSE_NONE ) && ( ctx->fileMode == MMB_MODE_CREATE ) )
+        {
+        status = openView( ctx, fileCreate, PREPARE_ALLOC, MMB_MAPPING_SHARED );
+        if ( status != MMB_OK ) return status;
+        if ( ctx->reuseMode == MMB_REUSE_FILE ) return closeView( ctx );
+        }
+    return MMB_OK;
+    }
+
+//--- Write phase: fill view, flush modified data to file, means write operation, with time measurement ---
+// INPUT:   ctx = benchmark context
+//          pass = number of pass, index for results logs
+// OUTPUT:  status, MMB_OK or error status with context errorText
+//          result MBPS stored to context logs[MMB_WRITE][pass]
+// File created per pass when not reused, previous pass file deleted first.
+// Reused file is overwritten in place, without blocks allocation.
+// All flush modes measure end-to-end durable write: fill, write back and flush file buffers,
+// async and pipelined modes overlap fill and write back by chunks, see fillAndFlush.
+// Anon and memfd targets have no backing store, fill is timed instead, in-memory reference
+// for subtract from file targets; anonymous memory kept up to next pass, read phase walks written data.
+//---
+int mmb_write( MMB_CONTEXT* ctx, int pass )
+    {
+    int status = MMB_OK;
+    LARGE_INTEGER t1, t2;    // results of QueryPerformanceCounter, at start and stop of measured interval
+    MMB_COUNTERS counters;    // performance counters at start of measured interval
+    //--- Balloon and limit of this pass, if memory sweep, first pass applied by setup ---
+    if ( ( ctx->sweepMode == MMB_SWEEP_MEMORY ) && ( pass > 0 ) )
+        {
+        status = applyPressure( ctx, pass );
+        if ( status != MMB_OK ) return status;
+        }
+    //--- Create or re-open file, create mapping object and map it to address space ---
+    if ( ctx->reuseMode == MMB_REUSE_NONE )
+        {
+        if ( ctx->targetExists )
+            {
+            status = deleteTarget( ctx );
+            if ( status != MMB_OK ) return status;
+            }
+        status = openView( ctx, fileCreate, PREPARE_ALLOC, MMB_MAPPING_SHARED );
+        }
+    else if ( ctx->reuseMode == MMB_REUSE_FILE )
+        {
+        status = openView( ctx, fileOpen, PREPARE_NONE, MMB_MAPPING_SHARED );
+        }
+    if ( status != MMB_OK ) return status;
+    if ( ( ctx->targetMode == MMB_TARGET_ANON ) | ( ctx->targetMode == MMB_TARGET_MEMFD ) )
+        {
+        //--- No backing store, flush is nothing, fill timed as in-memory reference ---
+        Sleep( ctx->writeDelay );
+        startCounters( ctx, &counters );
+        QueryPerformanceCounter( &t1 );
+        memset ( ctx->mapPointer, SET_DATA, viewSize( ctx ) );
+        QueryPerformanceCounter( &t2 );
+        storeCounters( ctx, MMB_WRITE, pass, &counters );
+        ctx->logs[MMB_WRITE][pass] = calculateMbps( viewSize( ctx ), &t1, &t2 );
+        if ( ctx->reuseMode != MMB_REUSE_VIEW ) return closeView( ctx );
+        return MMB_OK;
+        }
+    //--- Fill and flush by selected mode, with time measurement up to durable data ---
+    Sleep( ctx->writeDelay );
+    startCounters( ctx, &counters );
+    QueryPerformanceCounter( &t1 );
+    status = fillAndFlush( ctx );
+    QueryPerformanceCounter( &t2 );
+    storeCounters( ctx, MMB_WRITE, pass, &counters );
+    if ( status != MMB_OK ) return status;
+    ctx->logs[MMB_WRITE][pass] = calculateMbps( viewSize( ctx ), &t1, &t2 );
+    //--- Close mapping object and file, unmap view of file, note file not deleted for next operations ---
+    if ( ctx->reuseMode != MMB_REUSE_VIEW ) return closeView( ctx );
+    return MMB_OK;
+    }
+
+//--- Read phase: page walk means swap operation, then write-touch, with time measurement ---
+// INPUT:   ctx = benchmark context
+//          pass = number of pass, index for results logs
+// OUTPUT:  status, MMB_OK or error status with context errorText
+//          results stored to context logs[MMB_READ], logs[MMB_TOUCH], logs[MMB_FAULT]
+// Mapping mode selects shared, private copy-on-write or read-only view for this phase.
+// Write-touch writes to each page already mapped by read walk, with per-fault time measurement:
+// for private mapping each first write is copy-on-write fault; shared mapping touched only with
+// touch option, dirty page fault used as reference. Read-only mapping skips write-touch.
+// With rate, read walk is open-loop at offered rate for this pass, see mmb_rate,
+// touch latency percentiles stored to logs[MMB_RP50], logs[MMB_RP99], achieved rate to logs[MMB_ACHIEVED].
+//---
+int mmb_read( MMB_CONTEXT* ctx, int pass )
+    {
+    int status = MMB_OK;
+    LARGE_INTEGER t1, t2;
+    MMB_COUNTERS counters;
+    size_t walkCount = 0;
+    size_t walkLimit = walkPages( ctx );
+    volatile char walkData = 0;
+    char* walkPointer = NULL;
+    DWORD faults = 0;
+    int rate = mmb_rate( ctx, pass );
+    double achieved = 0.0;
+    double* touchLatencies = NULL;
+    //--- Re-Open file, re-create mapping object and map it to address space ---
+    if ( ctx->reuseMode != MMB_REUSE_VIEW )
+        {
+        status = openView( ctx, fileOpen, PREPARE_NONE, ctx->mappingMode );
+        if ( status != MMB_OK ) return status;
+        }
+    if ( rate != 0 )
+        {
+        touchLatencies = (double *) malloc( walkLimit * sizeof(double) );
+        if ( touchLatencies == NULL )
+            {
+            closeView( ctx );
+            return setError( ctx, MMB_ERROR, "Error allocate latency array" );
+            }
+        }
+    //--- Page walk, with time measurement ---
+    Sleep( ctx->readDelay );
+    walkPointer = walkBase( ctx );
+    faults = pageFaults();
+    startCounters( ctx, &counters );
+    QueryPerformanceCounter( &t1 );
+    if ( rate != 0 )
+        {
+        achieved = scheduledWalk( ctx, rate, touchLatencies );
+        }
+    else
+        {
+        for ( walkCount=0; walkCount<walkLimit; walkCount++ )
+            {
+            walkData = *walkPointer;   // this causes swapping or DAX map for adressed pages
+            walkPointer += ctx->walkStep;
+            }
+        }
+    QueryPerformanceCounter( &t2 );
+    storeCounters( ctx, MMB_READ, pass, &counters );
+    faults = pageFaults() - faults;
+    ctx->logs[MMB_READ][pass] = calculateMbps( walkSize( ctx ), &t1, &t2 );
+    ctx->logs[MMB_RFAULTS][pass] = (double)faults / walkLimit;
+    if ( rate != 0 )
+        {
+        ctx->logs[MMB_RP50][pass] = calculateMedian( touchLatencies, walkLimit );
+        ctx->logs[MMB_RP99][pass] = touchLatencies[ (size_t)( ( walkLimit - 1 ) * 0.99 ) ];
+        ctx->logs[MMB_ACHIEVED][pass] = achieved;
+        free( touchLatencies );
+        }
+    //--- Write-touch, with per-fault time measurement ---
+    if ( mmb_enabled( ctx, MMB_TOUCH ) )
+        {
+        LARGE_INTEGER qpc1, qpc2, qpcFrequency;
+        double* faultLatencies = (double *) malloc( walkLimit * sizeof(double) );
+        if ( faultLatencies == NULL )
+            {
+            closeView( ctx );
+            return setError( ctx, MMB_ERROR, "Error allocate latency array" );
+            }
+        QueryPerformanceFrequency( &qpcFrequency );
+        walkPointer = walkBase( ctx );
+        startCounters( ctx, &counters );
+        QueryPerformanceCounter( &t1 );
+        for ( walkCount=0; walkCount<walkLimit; walkCount++ )
+            {
+            QueryPerformanceCounter( &qpc1 );
+            *walkPointer = SET_DATA;   // this causes copy-on-write fault for private mapping
+            QueryPerformanceCounter( &qpc2 );
+            faultLatencies[walkCount] = (double)( qpc2.QuadPart - qpc1.QuadPart );
+            walkPointer += ctx->walkStep;
+            }
+        QueryPerformanceCounter( &t2 );
+        storeCounters( ctx, MMB_TOUCH, pass, &counters );
+        ctx->logs[MMB_TOUCH][pass] = calculateMbps( walkSize( ctx ), &t1, &t2 );
+        ctx->logs[MMB_FAULT][pass] = calculateMedian( faultLatencies, walkLimit ) *
+                                     SECONDS_TO_MICROSECONDS / qpcFrequency.QuadPart;
+        free( faultLatencies );
+        }
+    //--- Close mapping object and file, unmap view of file ---
+    if ( ctx->reuseMode != MMB_REUSE_VIEW ) return closeView( ctx );
+    return MMB_OK;
+    }
+
+//--- Punch-hole phase: deallocate all blocks, refault into holes by write page walk ---
+// INPUT:   ctx = benchmark context
+//          pass = number of pass, index for results logs
+// OUTPUT:  status, MMB_OK or error status with context errorText
+//          result MBPS stored to context logs[MMB_REFAULT][pass]
+// Write to each page causes fault into hole, flush causes blocks allocation.
+// Nothing to do if punch-hole phase not enabled.
+//---
+int mmb_punch( MMB_CONTEXT* ctx, int pass )
+    {
+    int status = MMB_OK;
+    LARGE_INTEGER t1, t2;
+    MMB_COUNTERS counters;
+    size_t punchCount = 0;
+    size_t punchLimit = walkPages( ctx );
+    char* punchPointer = NULL;
+    if ( ctx->punchMode == 0 ) return MMB_OK;
+    status = openView( ctx, fileOpen, PREPARE_PUNCH, MMB_MAPPING_SHARED );
+    if ( status != MMB_OK ) return status;
+    Sleep( ctx->readDelay );
+    punchPointer = walkBase( ctx );
+    startCounters( ctx, &counters );
+    QueryPerformanceCounter( &t1 );
+    for ( punchCount=0; punchCount<punchLimit; punchCount++ )
+        {
+        *punchPointer = SET_DATA;
+        punchPointer += ctx->walkStep;
+        }
+    status = flushView( ctx );
+    QueryPerformanceCounter( &t2 );
+    storeCounters( ctx, MMB_REFAULT, pass, &counters );
+    if ( status == 0 ) return setError( ctx, MMB_ERROR, "Error flush file" );
+    ctx->logs[MMB_REFAULT][pass] = calculateMbps( walkSize( ctx ), &t1, &t2 );
+    return closeView( ctx );
+    }
+
+//--- Straddle phase: cold page aligned probes and probes straddling page boundary, with per-probe time measurement ---
+// INPUT:   ctx = benchmark context
+//          pass = number of pass, index for results logs
+// OUTPUT:  status, MMB_OK or error status with context errorText
+//          results stored to context logs[MMB_ALIGNED], logs[MMB_STRADDLE], microseconds,
+//          page faults per probe to logs[MMB_AFAULTS], logs[MMB_SFAULTS]
+// View divided to groups of STRADDLE_GROUP fault-around windows. Aligned probe reads word at group start,
+// it faults first window. Straddled probe reads word split between two pages at window boundary nearest
+// below group middle, windows at both sides not mapped by any earlier probe: it faults two pages, and splits
+// cache line. Aligned and straddled probes are separate walks, so counters and faults per probe are
+// per probe kind; faults per straddled probe near 1 means larger fault-around window mapped both pages.
+// Difference of medians is page-straddling access cost. Nothing to do if straddle phase not enabled.
+//---
+int mmb_straddle( MMB_CONTEXT* ctx, int pass )
+    {
+    int status = MMB_OK;
+    MMB_COUNTERS counters;
+    LARGE_INTEGER qpc1, qpc2, qpcFrequency;
+    size_t groupSize = straddleGroup( ctx );
+    size_t windowSize = groupSize / STRADDLE_GROUP;
+    size_t windowSkew = 0;
+    size_t straddleOffset = 0;
+    size_t groups = viewSize( ctx ) / groupSize;
+    size_t i = 0;
+    int straddled = 0;
+    DWORD faults = 0;
+    char* probePointer = NULL;
+    unsigned long long probeWord = 0;
+    volatile unsigned long long probeData = 0;
+    double* alignedLatencies = NULL;
+    double* latencies = NULL;
+    if ( ctx->straddleMode == 0 ) return MMB_OK;
+    alignedLatencies = (double *) malloc( groups * 2 * sizeof(double) );
+    if ( alignedLatencies == NULL ) return setError( ctx, MMB_ERROR, "Error allocate latency array" );
+    if ( ctx->targetMode == MMB_TARGET_ANON ) status = deleteTarget( ctx );   // written region is resident, probe fresh one
+    if ( status == MMB_OK ) status = openView( ctx, fileOpen, PREPARE_NONE, ctx->mappingMode );
+    if ( status != MMB_OK )
+        {
+        free( alignedLatencies );
+        return status;
+        }
+    //--- Fault-around window is aligned by virtual address, view start can be not aligned on Linux ---
+    windowSkew = (size_t) ctx->mapPointer % windowSize;
+    straddleOffset = ( windowSkew + groupSize / 2 ) / windowSize * windowSize - windowSkew - STRADDLE_WORD / 2;
+    Sleep( ctx->readDelay );
+    QueryPerformanceFrequency( &qpcFrequency );
+    for ( straddled=0; straddled<2; straddled++ )
+        {
+        latencies = alignedLatencies + groups * straddled;
+        probePointer = (char *) ctx->mapPointer + ( straddled ? straddleOffset : 0 );
+        faults = pageFaults();
+        startCounters( ctx, &counters );
+        for ( i=0; i<groups; i++ )
+            {
+            QueryPerformanceCounter( &qpc1 );
+            memcpy( &probeWord, probePointer, STRADDLE_WORD );
+            QueryPerformanceCounter( &qpc2 );
+            probeData = probeWord;
+            latencies[i] = (double)( qpc2.QuadPart - qpc1.QuadPart );
+            probePointer += groupSize;
+            }
+        storeCounters( ctx, straddled ? MMB_STRADDLE : MMB_ALIGNED, pass, &counters );
+        faults = pageFaults() - faults;
+        ctx->logs[straddled ? MMB_SFAULTS : MMB_AFAULTS][pass] = (double)faults / groups;
+        ctx->logs[straddled ? MMB_STRADDLE : MMB_ALIGNED][pass] = calculateMedian( latencies, groups ) *
+                                                                  SECONDS_TO_MICROSECONDS / qpcFrequency.QuadPart;
+        }
+    free( alignedLatencies );
+    return closeView( ctx );
+    }
+
+//--- Teardown benchmark: close view if open, delete file or section ---
+// INPUT:   ctx = benchmark context
+// OUTPUT:  status, MMB_OK or error status with context errorText
+// Can be called after any phase error, closes objects opened at the moment.
+//---
+int mmb_teardown( MMB_CONTEXT* ctx )
+    {
+    int status = MMB_OK;
+    if ( ctx->viewOpen || ( ctx->fileHandle != NULL ) || ( ctx->mapHandle != NULL ) )
+        {
+        status = closeView( ctx );
+        }
+    if ( ctx->targetExists )
+        {
+        int deleteStatus = deleteTarget( ctx );
+        if ( status == MMB_OK ) status = deleteStatus;
+        }
+    if ( ( ctx->balloonPointer != NULL ) || ctx->limitsSet )
+        {
+        int releaseStatus = releasePressure( ctx );
+        if ( status == MMB_OK ) status = releaseStatus;
+        }
+#if !defined(_WIN32)
+    PerfEventsClose( ctx->perfEvents );
+#endif
+    return status;
+    }
+
+//--- Check phase measured with current options ---
+// INPUT:   ctx = benchmark context
+//          phase = measured phase, MMB_WRITE ... MMB_RFAULTS
+// OUTPUT:  1 = phase measured, 0 = phase skipped
+//---
+int mmb_enabled( MMB_CONTEXT* ctx, int phase )
+    {
+    if ( ctx->fileMode == MMB_MODE_EXISTING )
+        {
+        if ( phase == MMB_HOT ) return ctx->hotset != NULL;
+        return ( phase >= MMB_OPEN ) & ( phase <= MMB_HOT );
+        }
+    switch( phase )
+        {
+        case MMB_TOUCH:
+        case MMB_FAULT:
+            return ( ctx->trace == NULL ) &&
+                   ( ( ctx->mappingMode == MMB_MAPPING_PRIVATE ) || ( ( ctx->mappingMode == MMB_MAPPING_SHARED ) && ctx->touchMode ) );
+        case MMB_REFAULT:
+            return ( ctx->trace == NULL ) && ( ctx->punchMode != 0 );
+        case MMB_REPLAY:
+        case MMB_P50:
+        case MMB_P99:
+            return ctx->trace != NULL;
+        case MMB_RFAULTS:
+            return ( ctx->trace == NULL ) && ( ( ctx->pressureSize != 0 ) || ( ctx->memoryLimit != 0 ) );
+        case MMB_RP50:
+        case MMB_RP99:
+        case MMB_ACHIEVED:
+            return ( ctx->trace == NULL ) && ( ctx->touchRate != 0 );
+        case MMB_ALIGNED:
+        case MMB_STRADDLE:
+        case MMB_AFAULTS:
+        case MMB_SFAULTS:
+            return ( ctx->trace == NULL ) && ( ctx->straddleMode != 0 );
+        case MMB_OPEN:
+        case MMB_MAP:
+        case MMB_VIEW:
+        case MMB_FIRST:
+        case MMB_STARTUP:
+        case MMB_HOT:
+            return 0;
+        }
+    return ctx->trace == NULL;
+    }
+
+//--- Check performance counters collected for phase timed region ---
+// INPUT:   ctx = benchmark context
+//          phase = measured phase, MMB_WRITE ... MMB_P99
+// OUTPUT:  1 = counters collected, 0 = counters disabled, or phase is derived from other phase timed region
+//---
+int mmb_counted( MMB_CONTEXT* ctx, int phase )
+    {
+    if ( ctx->countersMode == 0 ) return 0;
+    if ( ( phase == MMB_FAULT ) | ( phase == MMB_P50 ) | ( phase == MMB_P99 ) | ( phase == MMB_RFAULTS ) |
+         ( phase == MMB_RP50 ) | ( phase == MMB_RP99 ) | ( phase == MMB_ACHIEVED ) |
+         ( phase == MMB_AFAULTS ) | ( phase == MMB_SFAULTS ) ) return 0;
+    if ( ( phase >= MMB_OPEN ) & ( phase <= MMB_HOT ) & ( phase != MMB_STARTUP ) ) return 0;
+    return mmb_enabled( ctx, phase );
+    }
+
+//--- Offered read walk rate for pass ---
+// INPUT:   ctx = benchmark context
+//          pass = number of pass
+// OUTPUT:  rate, pages per second, 0 means closed-loop walk;
+//          with rate sweep pass k runs at rate * (k+1) / repeats, last pass at full rate
+//---
+int mmb_rate( MMB_CONTEXT* ctx, int pass )
+    {
+    long long rate = ctx->touchRate;
+    if ( ( ctx->sweepMode != MMB_SWEEP_RATE ) | ( ctx->repeats == 0 ) ) return ctx->touchRate;
+    rate = rate * ( pass + 1 ) / ctx->repeats;
+    if ( rate < 1 ) rate = 1;
+    return (int)rate;
+    }
+
+//--- Locked balloon size for pass ---
+// INPUT:   ctx = benchmark context
+//          pass = number of pass
+// OUTPUT:  balloon size, bytes, 0 means no balloon;
+//          with memory sweep pass k locks pressure * (k+1) / repeats, last pass full balloon
+//---
+size_t mmb_pressure( MMB_CONTEXT* ctx, int pass )
+    {
+    if ( ( ctx->sweepMode != MMB_SWEEP_MEMORY ) | ( ctx->repeats == 0 ) ) return ctx->pressureSize;
+    return ( ctx->pressureSize / ctx->repeats * ( pass + 1 ) ) & ~( ctx->pageSize - 1 );
+    }
+
+//--- Hard working set limit for pass ---
+// INPUT:   ctx = benchmark context
+//          pass = number of pass
+// OUTPUT:  limit, bytes, 0 means no limit;
+//          with memory sweep pass k runs at limit * (repeats-k) / repeats, first pass at full limit,
+//          so working set exceeds available memory more at each next pass, not below minimum limit
+//---
+size_t mmb_limit( MMB_CONTEXT* ctx, int pass )
+    {
+    size_t limit = ctx->memoryLimit;
+    if ( ( ctx->sweepMode != MMB_SWEEP_MEMORY ) | ( ctx->repeats == 0 ) | ( limit == 0 ) ) return limit;
+    limit = ( limit / ctx->repeats * ( ctx->repeats - pass ) ) & ~( ctx->pageSize - 1 );
+    if ( limit < LIMIT_MIN ) limit = LIMIT_MIN;
+    return limit;
+    }
+
+//--- Calculate median, average, minimum, maximum for phase results ---
+// INPUT:   ctx = benchmark context
+//          phase = measured phase, MMB_WRITE ... MMB_RFAULTS
+//          count = number of passes for statistics, first passes used
+//          stats = pointer to statistics for update
+// Context log not reordered, statistics calculated for copy.
+//---
+void mmb_stats( MMB_CONTEXT* ctx, int phase, int count, MMB_STATS* stats )
+    {
+    double statArray[MMB_REPEATS_MAX];
+    memset( stats, 0, sizeof(MMB_STATS) );
+    if ( count <= 0 ) return;
+    memcpy( statArray, ctx->logs[phase], count * sizeof(double) );
+    calculateStatistics( statArray, count, &stats->median, &stats->average, &stats->minimum, &stats->maximum );
+    }
+
+//---------- Trace replay ------------------------------------------------------
+
+//--- Helper method for add record to trace, grow records array if required ---
+// INPUT:   trace = trace for update
+//          record = new record
+// OUTPUT:  status, 0=OK, otherwise memory allocation error
+//---
+static int addRecord( MMB_TRACE* trace, MMB_RECORD* record )
+    {
+    MMB_RECORD* grown = NULL;
+    size_t end = record->offset + record->length;
+    if ( ( trace->count % TRACE_GROW ) == 0 )
+        {
+        grown = (MMB_RECORD *) realloc( trace->records, ( trace->count + TRACE_GROW ) * sizeof(MMB_RECORD) );
+        if ( grown == NULL ) return 1;
+        trace->records = grown;
+        }
+    trace->records[trace->count++] = *record;
+    if ( trace->threads <= record->thread ) trace->threads = record->thread + 1;
+    if ( trace->span < end ) trace->span = end;
+    return 0;
+    }
+
+//--- Load trace file: binary if signature detected, otherwise text ---
+// INPUT:   ctx = benchmark context, for error description
+//          path = trace file path
+//          trace = trace for load, previous content not released
+// OUTPUT:  status, MMB_OK, MMB_BAD_PARAMETER for format errors, MMB_ERROR for file errors
+// Text format: one record per line "offset length op thread delta", op is r or w,
+// delta is microseconds from previous record, offset accepts 0x prefix, "#" starts comment.
+// Binary format: signature "MMBTRACE", then little-endian records of 20 bytes:
+// offset (8), length (4), delta (4), thread (2), op (1, 0=read, 1=write), reserved (1).
+//---
+int mmb_trace_load( MMB_CONTEXT* ctx, char* path, MMB_TRACE* trace )
+    {
+    FILE* traceFile = NULL;
+    unsigned char buffer[TRACE_LINE_MAX];
+    char op[TRACE_LINE_MAX];
+    MMB_RECORD record;
+    unsigned long long time = 0;
+    unsigned long long offset = 0, length = 0, thread = 0, delta = 0;
+    size_t line = 0;
+    int i = 0;
+    memset( trace, 0, sizeof(MMB_TRACE) );
+    traceFile = fopen( path, "rb" );
+    if ( traceFile == NULL ) return setError( ctx, MMB_ERROR, "Error open trace file %s", path );
+    if ( ( fread( buffer, 1, TRACE_SIGNATURE_SIZE, traceFile ) == TRACE_SIGNATURE_SIZE ) &&
+         ( memcmp( buffer, TRACE_SIGNATURE, TRACE_SIGNATURE_SIZE ) == 0 ) )
+        {
+        //--- Binary trace ---
+        while ( fread( buffer, 1, TRACE_RECORD_SIZE, traceFile ) == TRACE_RECORD_SIZE )
+            {
+            offset = 0;
+            for ( i=7; i>=0; i-- ) offset = ( offset << 8 ) | buffer[i];
+            length = buffer[8]  | ( buffer[9] << 8 )  | ( buffer[10] << 16 ) | ( (unsigned long long)buffer[11] << 24 );
+            delta  = buffer[12] | ( buffer[13] << 8 ) | ( buffer[14] << 16 ) | ( (unsigned long long)buffer[15] << 24 );
+            thread = buffer[16] | ( buffer[17] << 8 );
+            time += delta;
+            record.offset = offset;
+            record.length = (unsigned int)length;
+            record.time = time;
+            record.thread = (unsigned short)thread;
+            record.write = buffer[18] != 0;
+            if ( ( record.length == 0 ) || ( record.thread >= THREADS_MAX ) )
+                {
+                fclose( traceFile );
+                mmb_trace_free( trace );
+                return setError( ctx, MMB_BAD_PARAMETER, "Trace record %u invalid, length zero or thread above %d",
+                                 (unsigned int)trace->count + 1, THREADS_MAX - 1 );
+                }
+            if ( addRecord( trace, &record ) != 0 )
+                {
+                fclose( traceFile );
+                mmb_trace_free( trace );
+                return setError( ctx, MMB_ERROR, "Error allocate trace" );
+                }
+            }
+        }
+    else
+        {
+        //--- Text trace ---
+        rewind( traceFile );
+        while ( fgets( (char *) buffer, TRACE_LINE_MAX, traceFile ) != NULL )
+            {
+            char* comment = strchr( (char *) buffer, '#' );
+            line++;
+            if ( comment != NULL ) *comment = 0;
+            i = sscanf( (char *) buffer, "%lli %lli %s %lli %lli", (long long *)&offset, (long long *)&length, op,
+                        (long long *)&thread, (long long *)&delta );
+            if ( i <= 0 ) continue;   // skip empty and comment lines
+            if ( ( i != 5 ) || ( length == 0 ) || ( length > 0xFFFFFFFFULL ) || ( thread >= THREADS_MAX ) ||
+                 ( ( op[0] != 'r' ) && ( op[0] != 'w' ) && ( op[0] != 'R' ) && ( op[0] != 'W' ) ) || ( op[1] != 0 ) )
+                {
+                fclose( traceFile );
+                mmb_trace_free( trace );
+                return setError( ctx, MMB_BAD_PARAMETER, "Trace line %u invalid, expected: offset length r|w thread delta",
+                                 (unsigned int)line );
+                }
+            time += delta;
+            record.offset = offset;
+            record.length = (unsigned int)length;
+            record.time = time;
+            record.thread = (unsigned short)thread;
+            record.write = ( op[0] == 'w' ) || ( op[0] == 'W' );
+            if ( addRecord( trace, &record ) != 0 )
+                {
+                fclose( traceFile );
+                mmb_trace_free( trace );
+                return setError( ctx, MMB_ERROR, "Error allocate trace" );
+                }
+            }
+        }
+    fclose( traceFile );
+    if ( trace->count == 0 ) return setError( ctx, MMB_BAD_PARAMETER, "Trace file %s has no records", path );
+    trace->span = ( ( trace->span + ctx->pageSize - 1 ) / ctx->pageSize ) * ctx->pageSize;
+    trace->latencies = (double *) calloc( trace->count, sizeof(double) );
+    if ( trace->latencies == NULL )
+        {
+        mmb_trace_free( trace );
+        return setError( ctx, MMB_ERROR, "Error allocate trace" );
+        }
+    return MMB_OK;
+    }
+
+//--- Release trace arrays ---
+// INPUT:   trace = trace loaded by mmb_trace_load
+//---
+void mmb_trace_free( MMB_TRACE* trace )
+    {
+    free( trace->records );
+    free( trace->latencies );
+    memset( trace, 0, sizeof(MMB_TRACE) );
+    }
+
+//--- Trace replay worker thread: accesses of one recorded thread ---
+// INPUT:   parm = pointer to REPLAY_WORKER structure
+// OUTPUT:  thread exit code, 0 = OK
+// Read access touches one byte per page of accessed range, write access fills range.
+// Open-loop replay waits up to intended start of each access, latency measured from
+// intended start, same as scheduledWalk, by waitUntil. Closed-loop replay latency measured from actual start.
+//---
+static DWORD WINAPI replayThread( LPVOID parm )
+    {
+    REPLAY_WORKER* worker = (REPLAY_WORKER *) parm;
+    MMB_CONTEXT* ctx = worker->ctx;
+    MMB_TRACE* trace = ctx->trace;
+    char* base = (char *) ctx->mapPointer;
+    volatile char walkData = 0;
+    LARGE_INTEGER now, issue;
+    long long intended = 0;
+    size_t i = 0;
+    size_t offset = 0;
+    for ( i=0; i<worker->count; i++ )
+        {
+        MMB_RECORD* record = &trace->records[worker->indexes[i]];
+        QueryPerformanceCounter( &issue );
+        if ( ctx->replayMode == MMB_REPLAY_OPEN )
+            {
+            intended = worker->start.QuadPart + (long long)( record->time * worker->frequency.QuadPart / 1000000 );
+            waitUntil( intended, &worker->frequency );
+            issue.QuadPart = intended;
+            }
+        if ( record->write )
+            {
+            memset( base + record->offset, SET_DATA, record->length );
+            }
+        else
+            {
+            for ( offset=0; offset<record->length; offset+=ctx->pageSize ) walkData = base[record->offset + offset];
+            walkData = base[record->offset + record->length - 1];
+            }
+        QueryPerformanceCounter( &now );
+        trace->latencies[worker->indexes[i]] =
+            (double)( now.QuadPart - issue.QuadPart ) * SECONDS_TO_MICROSECONDS / worker->frequency.QuadPart;
+        worker->bytes += record->length;
+        }
+    return 0;
+    }
+
+//--- Trace replay phase: accesses of loaded trace against mapped file, with time measurement ---
+// INPUT:   ctx = benchmark context, trace loaded
+//          pass = number of pass, index for results logs
+// OUTPUT:  status, MMB_OK or error status with context errorText
+//          results stored to context logs[MMB_REPLAY], logs[MMB_P50], logs[MMB_P99]
+// File created per pass when not reused, previous pass file deleted first.
+// New file filled with data and flushed before replay, so read accesses hit file data.
+//---
+int mmb_replay( MMB_CONTEXT* ctx, int pass )
+    {
+    MMB_TRACE* trace = ctx->trace;
+    REPLAY_WORKER workers[THREADS_MAX];
+    HANDLE threads[THREADS_MAX];
+    LARGE_INTEGER stop;
+    MMB_COUNTERS counters;
+    double* sorted = NULL;
+    long long bytes = 0;
+    int populate = ( ctx->reuseMode == MMB_REUSE_NONE ) || ( pass == 0 );
+    int status = MMB_OK;
+    int count = 0;
+    int i = 0;
+    size_t j = 0;
+    //--- Create or re-open file, create mapping object and map it to address space ---
+    if ( ctx->reuseMode == MMB_REUSE_NONE )
+        {
+        if ( ctx->targetExists )
+            {
+            status = deleteTarget( ctx );
+            if ( status != MMB_OK ) return status;
+            }
+        status = openView( ctx, fileCreate, PREPARE_ALLOC, MMB_MAPPING_SHARED );
+        }
+    else if ( ctx->reuseMode == MMB_REUSE_FILE )
+        {
+        status = openView( ctx, fileOpen, PREPARE_NONE, MMB_MAPPING_SHARED );
+        }
+    if ( status != MMB_OK ) return status;
+    if ( populate )
+        {
+        memset ( ctx->mapPointer, SET_DATA, ctx->fileSize );
+        if ( flushView( ctx ) == 0 ) return setError( ctx, MMB_ERROR, "Error flush file" );
+        }
+    Sleep( ctx->readDelay );
+    //--- Distribute records to threads, keep recorded order per thread ---
+    memset( workers, 0, sizeof(workers) );
+    for ( i=0; i<trace->threads; i++ )
+        {
+        workers[i].ctx = ctx;
+        workers[i].indexes = (size_t *) malloc( trace->count * sizeof(size_t) );
+        if ( workers[i].indexes == NULL )
+            {
+            while ( i > 0 ) free( workers[--i].indexes );
+            return setError( ctx, MMB_ERROR, "Error allocate trace" );
+            }
+        }
+    for ( j=0; j<trace->count; j++ )
+        {
+        REPLAY_WORKER* worker = &workers[trace->records[j].thread];
+        worker->indexes[worker->count++] = j;
+        }
+    //--- Replay by threads, with time measurement ---
+    QueryPerformanceFrequency( &workers[0].frequency );
+    startCounters( ctx, &counters );
+    QueryPerformanceCounter( &workers[0].start );
+    for ( i=0; i<trace->threads; i++ )
+        {
+        workers[i].frequency = workers[0].frequency;
+        workers[i].start = workers[0].start;
+        threads[count] = CreateThread( NULL, 0, replayThread, &workers[i], 0, NULL );
+        if ( threads[count] == NULL )
+            {
+            status = setError( ctx, MMB_ERROR, "Error create thread" );
+            break;
+            }
+        count++;
+        }
+    if ( count > 0 ) WaitForMultipleObjects( count, threads, TRUE, INFINITE );
+    QueryPerformanceCounter( &stop );
+    storeCounters( ctx, MMB_REPLAY, pass, &counters );
+    for ( i=0; i<count; i++ ) CloseHandle( threads[i] );
+    for ( i=0; i<trace->threads; i++ )
+        {
+        bytes += workers[i].bytes;
+        free( workers[i].indexes );
+        }
+    if ( status != MMB_OK ) return status;
+    //--- Results: throughput, latency percentiles ---
+    ctx->logs[MMB_REPLAY][pass] = (double)bytes / 1048576.0 /
+                                  ( (double)( stop.QuadPart - workers[0].start.QuadPart ) / workers[0].frequency.QuadPart );
+    sorted = (double *) malloc( trace->count * sizeof(double) );
+    if ( sorted == NULL ) return setError( ctx, MMB_ERROR, "Error allocate latency array" );
+    memcpy( sorted, trace->latencies, trace->count * sizeof(double) );
+    ctx->logs[MMB_P50][pass] = calculateMedian( sorted, trace->count );
+    ctx->logs[MMB_P99][pass] = sorted[ (size_t)( ( trace->count - 1 ) * 0.99 ) ];
+    free( sorted );
+    //--- Close mapping object and file, unmap view of file ---
+    if ( ctx->reuseMode != MMB_REUSE_VIEW ) return closeView( ctx );
+    return MMB_OK;
+    }
+
+//---------- Existing file startup ---------------------------------------------
+
+//--- Load hot set file: text, one offset per line ---
+// INPUT:   ctx = benchmark context, for error description
+//          path = hot set file path
+//          hotset = hot set for load, previous content not released
+// OUTPUT:  status, MMB_OK, MMB_BAD_PARAMETER for format errors, MMB_ERROR for file errors
+// Offset accepts 0x prefix, "#" starts comment.
+//---
+int mmb_hotset_load( MMB_CONTEXT* ctx, char* path, MMB_HOTSET* hotset )
+    {
+    FILE* hotsetFile = NULL;
+    char buffer[HOTSET_LINE_MAX];
+    unsigned long long* grown = NULL;
+    unsigned long long offset = 0;
+    size_t line = 0;
+    int i = 0;
+    memset( hotset, 0, sizeof(MMB_HOTSET) );
+    hotsetFile = fopen( path, "rt" );
+    if ( hotsetFile == NULL ) return setError( ctx, MMB_ERROR, "Error open hot set file %s", path );
+    while ( fgets( buffer, HOTSET_LINE_MAX, hotsetFile ) != NULL )
+        {
+        char* comment = strchr( buffer, '#' );
+        line++;
+        if ( comment != NULL ) *comment = 0;
+        i = sscanf( buffer, "%lli", (long long *)&offset );
+        if ( i == EOF ) continue;   // skip empty and comment lines
+        if ( i != 1 )
+            {
+            fclose( hotsetFile );
+            mmb_hotset_free( hotset );
+            return setError( ctx, MMB_BAD_PARAMETER, "Hot set line %u invalid, expected: offset", (unsigned int)line );
+            }
+        if ( ( hotset->count % HOTSET_GROW ) == 0 )
+            {
+            grown = (unsigned long long *) realloc( hotset->offsets, ( hotset->count + HOTSET_GROW ) * sizeof(unsigned long long) );
+            if ( grown == NULL )
+                {
+                fclose( hotsetFile );
+                mmb_hotset_free( hotset );
+                return setError( ctx, MMB_ERROR, "Error allocate hot set" );
+                }
+            hotset->offsets = grown;
+            }
+        hotset->offsets[hotset->count++] = offset;
+        if ( hotset->maximum < offset ) hotset->maximum = offset;
+        }
+    fclose( hotsetFile );
+    if ( hotset->count == 0 ) return setError( ctx, MMB_BAD_PARAMETER, "Hot set file %s has no offsets", path );
+    return MMB_OK;
+    }
+
+//--- Release hot set array ---
+// INPUT:   hotset = hot set loaded by mmb_hotset_load
+//---
+void mmb_hotset_free( MMB_HOTSET* hotset )
+    {
+    free( hotset->offsets );
+    memset( hotset, 0, sizeof(MMB_HOTSET) );
+    }
+
+//--- Helper method for purge cached pages of file, POSIX only, cold cache rejected on Windows by mmb_check ---
+// Port layer PurgeFileCache is posix_fadvise POSIX_FADV_DONTNEED, it drops clean
+// cached pages of file not mapped, existing file is mapped read-only so all pages clean.
+// INPUT:   ctx = benchmark context
+// OUTPUT:  status, MMB_OK or MMB_ERROR with context errorText
+//---
+static int purgeCache( MMB_CONTEXT* ctx )
+    {
+    BOOL purged = FALSE;
+    HANDLE hFile = CreateFile( ctx->filePath, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL,
+                               OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL );
+    if ( ( hFile == NULL ) || ( hFile == INVALID_HANDLE_VALUE ) ) return setError( ctx, MMB_ERROR, "Error open file for purge cache" );
+#if !defined(_WIN32)
+    purged = PurgeFileCache( hFile );
+#endif
+    CloseHandle( hFile );
+    if ( !purged ) return setError( ctx, MMB_ERROR, "Error purge file cache" );
+    return MMB_OK;
+    }
+
+//--- Helper method for convert QueryPerformanceCounter interval to microseconds ---
+// INPUT:   t1, t2 = counter values at start and stop of interval
+//          frequency = QueryPerformanceFrequency value
+// OUTPUT:  interval, microseconds
+//---
+static double qpcMicroseconds( LARGE_INTEGER* t1, LARGE_INTEGER* t2, LARGE_INTEGER* frequency )
+    {
+    return (double)( t2->QuadPart - t1->QuadPart ) * SECONDS_TO_MICROSECONDS / frequency->QuadPart;
+    }
+
+//--- Startup phase: open existing file, map it read-only, touch first pages and hot set, with time measurement ---
+// INPUT:   ctx = benchmark context
+//          pass = number of pass, index for results logs
+// OUTPUT:  status, MMB_OK or error status with context errorText
+//          results stored to context logs[MMB_OPEN] ... logs[MMB_HOT], microseconds
+// File opened with share read and write, so file can be used by other applications,
+// file not modified and not deleted. Cold cache mode purges file cache before timed region.
+//---
+int mmb_startup( MMB_CONTEXT* ctx, int pass )
+    {
+    int status = MMB_OK;
+    LARGE_INTEGER frequency, t0, t1, t2, t3, t4, t5;
+    MMB_COUNTERS counters;
+    size_t filePages = ( ctx->fileSize + ctx->walkStep - 1 ) / ctx->walkStep;
+    size_t firstLimit = ctx->firstPages;
+    size_t i = 0;
+    volatile char walkData = 0;
+    char* base = NULL;
+    if ( firstLimit > filePages ) firstLimit = filePages;
+    if ( ctx->cacheMode == MMB_CACHE_COLD )
+        {
+        status = purgeCache( ctx );
+        if ( status != MMB_OK ) return status;
+        }
+    Sleep( ctx->readDelay );
+    QueryPerformanceFrequency( &frequency );
+    //--- Open file, create mapping object and view, read-only ---
+    startCounters( ctx, &counters );
+    QueryPerformanceCounter( &t0 );
+    ctx->fileHandle = CreateFile( ctx->filePath, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL,
+                                  OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL );
+    QueryPerformanceCounter( &t1 );
+    if ( ( ctx->fileHandle == NULL ) || ( ctx->fileHandle == INVALID_HANDLE_VALUE ) )
+        {
+        ctx->fileHandle = NULL;
+        return setError( ctx, MMB_ERROR, "Error open file" );
+        }
+    ctx->mapHandle = CreateFileMapping( ctx->fileHandle, NULL, PAGE_READONLY, 0, 0, NULL );
+    QueryPerformanceCounter( &t2 );
+    if ( ctx->mapHandle == NULL ) return setError( ctx, MMB_ERROR, "Error create mapping" );
+    ctx->mapPointer = MapViewOfFile( ctx->mapHandle, FILE_MAP_READ, 0, 0, 0 );
+    QueryPerformanceCounter( &t3 );
+    if ( ctx->mapPointer == NULL ) return setError( ctx, MMB_ERROR, "Error create view" );
+    ctx->viewOpen = 1;
+    //--- Touch first pages, then hot set offsets ---
+    base = (char *) ctx->mapPointer;
+    for ( i=0; i<firstLimit; i++ ) walkData = base[i * ctx->walkStep];
+    QueryPerformanceCounter( &t4 );
+    storeCounters( ctx, MMB_STARTUP, pass, &counters );
+    if ( ctx->hotset != NULL )
+        {
+        for ( i=0; i<ctx->hotset->count; i++ ) walkData = base[ctx->hotset->offsets[i]];
+        }
+    QueryPerformanceCounter( &t5 );
+    //--- Results ---
+    ctx->logs[MMB_OPEN][pass]    = qpcMicroseconds( &t0, &t1, &frequency );
+    ctx->logs[MMB_MAP][pass]     = qpcMicroseconds( &t1, &t2, &frequency );
+    ctx->logs[MMB_VIEW][pass]    = qpcMicroseconds( &t2, &t3, &frequency );
+    ctx->logs[MMB_FIRST][pass]   = qpcMicroseconds( &t3, &t4, &frequency );
+    ctx->logs[MMB_STARTUP][pass] = qpcMicroseconds( &t0, &t4, &frequency );
+    ctx->logs[MMB_HOT][pass]     = qpcMicroseconds( &t4, &t5, &frequency );
+    return closeView( ctx );
+    }
+
+//---------- Scenario ----------------------------------------------------------
+
+//--- Helper method for pseudo-random numbers, xorshift, independent state per thread ---
+// INPUT:   state = pointer to generator state, must be nonzero
+// OUTPUT:  next pseudo-random number
+//---
+static unsigned long long nextRandom( unsigned long long* state )
+    {
+    unsigned long long x = *state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    *state = x;
+    return x;
+    }
+
+//--- Helper method for check scenario phase duration expired or stop requested ---
+// INPUT:   worker = thread data
+// OUTPUT:  1 = stop thread, 0 = continue
+//---
+static int workerDone( WORKER* worker )
+    {
+    LARGE_INTEGER now;
+    if ( *worker->stop != 0 ) return 1;
+    if ( worker->deadline.QuadPart == 0 ) return 0;
+    QueryPerformanceCounter( &now );
+    return now.QuadPart >= worker->deadline.QuadPart;
+    }
+
+//--- Scenario worker thread: read or write page walk, or flush view ---
+// INPUT:   parm = pointer to WORKER structure
+// OUTPUT:  thread exit code, 0 = OK
+// Sequential pattern walks thread slice of file, random pattern walks all file.
+// Without duration, walk is one pass: slice pages for sequential pattern,
+// same number of random pages for random pattern, one flush for flush phase.
+// Duration and stop conditions checked once per WORKER_CHECK pages.
+//---
+#define WORKER_CHECK 64
+static DWORD WINAPI workerThread( LPVOID parm )
+    {
+    WORKER* worker = (WORKER *) parm;
+    MMB_PHASE* phase = worker->phase;
+    char* base = (char *) worker->ctx->mapPointer;
+    size_t step = worker->ctx->walkStep;
+    size_t pages = ( worker->ctx->fileSize + step - 1 ) / step;
+    size_t slice = pages / phase->threads;
+    size_t first = slice * worker->index;
+    size_t count = 0;
+    size_t page = 0;
+    unsigned long long seed = 0x9E3779B97F4A7C15ULL * ( worker->index + 1 );
+    volatile char walkData = 0;
+    int loop = ( phase->duration > 0 ) || phase->background;
+    if ( worker->index == ( phase->threads - 1 ) ) slice = pages - first;   // last thread gets remainder
+    //--- Flush phase ---
+    if ( phase->type == MMB_SCENARIO_FLUSH )
+        {
+        do  {
+            if ( phase->interval > 0 ) Sleep( phase->interval );
+            if ( flushView( worker->ctx ) == 0 )   // anon target has no view, nothing to flush
+                {
+                worker->status = 1;
+                return 1;
+                }
+            worker->operations++;
+            } while ( loop && ( workerDone( worker ) == 0 ) );
+        return 0;
+        }
+    //--- Read or write phase ---
+    if ( slice == 0 ) return 0;
+    do  {
+        for ( count=0; count<slice; count++ )
+            {
+            if ( phase->pattern == MMB_PATTERN_RANDOM )
+                page = nextRandom( &seed ) % pages;
+            else
+                page = first + count;
+            if ( phase->type == MMB_SCENARIO_WRITE )
+                base[page * step] = SET_DATA;
+            else
+                walkData = base[page * step];
+            worker->operations++;
+            if ( loop && ( ( count % WORKER_CHECK ) == 0 ) && workerDone( worker ) ) return 0;
+            }
+        } while ( loop && ( workerDone( worker ) == 0 ) );
+    return 0;
+    }
+
+//--- Helper method for start scenario phase threads ---
+// INPUT:   ctx = benchmark context
+//          run = phase execution state, phase pointer set by caller
+//          stop = pointer to stop flag for background phases
+// OUTPUT:  status, MMB_OK or MMB_ERROR with context errorText
+//---
+static int startPhase( MMB_CONTEXT* ctx, PHASE_RUN* run, volatile LONG* stop )
+    {
+    LARGE_INTEGER frequency;
+    int i = 0;
+    QueryPerformanceFrequency( &frequency );
+    QueryPerformanceCounter( &run->start );
+    run->count = 0;
+    for ( i=0; i<run->phase->threads; i++ )
+        {
+        WORKER* worker = &run->workers[i];
+        memset( worker, 0, sizeof(WORKER) );
+        worker->ctx = ctx;
+        worker->phase = run->phase;
+        worker->index = i;
+        worker->stop = stop;
+        if ( run->phase->duration > 0 )
+            {
+            worker->deadline.QuadPart = run->start.QuadPart + frequency.QuadPart * run->phase->duration / 1000;
+            }
+        run->threads[i] = CreateThread( NULL, 0, workerThread, worker, 0, NULL );
+        if ( run->threads[i] == NULL ) return setError( ctx, MMB_ERROR, "Error create thread" );
+        run->count++;
+        }
+    return MMB_OK;
+    }
+
+//--- Helper method for wait scenario phase threads and calculate phase results ---
+// INPUT:   ctx = benchmark context
+//          run = phase execution state, threads started by startPhase
+// OUTPUT:  status, MMB_OK or MMB_ERROR with context errorText
+//---
+static int finishPhase( MMB_CONTEXT* ctx, PHASE_RUN* run )
+    {
+    LARGE_INTEGER frequency, stop;
+    int status = MMB_OK;
+    int i = 0;
+    MMB_PHASE* phase = run->phase;
+    if ( run->count > 0 ) WaitForMultipleObjects( run->count, run->threads, TRUE, INFINITE );
+    QueryPerformanceCounter( &stop );
+    QueryPerformanceFrequency( &frequency );
+    phase->operations = 0;
+    for ( i=0; i<run->count; i++ )
+        {
+        CloseHandle( run->threads[i] );
+        phase->operations += run->workers[i].operations;
+        if ( ( run->workers[i].status != 0 ) && ( status == MMB_OK ) )
+            {
+            status = setError( ctx, MMB_ERROR, "Error %s phase worker", mmbScenarioNames[phase->type] );
+            }
+        }
+    run->count = 0;
+    phase->seconds = (double)( stop.QuadPart - run->start.QuadPart ) / frequency.QuadPart;
+    if ( phase->type != MMB_SCENARIO_FLUSH )
+        {
+        phase->megabytes = (double)phase->operations * ctx->walkStep / 1048576.0;
+        phase->mbps = phase->megabytes / phase->seconds;
+        }
+    return status;
+    }
+
+//--- Helper method for stop background phases and wait its threads ---
+// INPUT:   ctx = benchmark context
+//          runs = phases execution state
+//          count = number of phases to check, phases with no running threads skipped
+//          stop = pointer to stop flag for background phases
+//          status = status of scenario before stop
+// OUTPUT:  status, input status if not MMB_OK, otherwise first failed phase status,
+//          context errorText keeps description of first error
+//---
+static int stopPhases( MMB_CONTEXT* ctx, PHASE_RUN runs[], int count, volatile LONG* stop, int status )
+    {
+    char savedText[MMB_ERROR_MAX];
+    int i = 0;
+    strcpy( savedText, ctx->errorText );
+    *stop = 1;
+    for ( i=0; i<count; i++ )
+        {
+        if ( runs[i].count > 0 )
+            {
+            int phaseStatus = finishPhase( ctx, &runs[i] );
+            if ( status == MMB_OK ) status = phaseStatus;
+            else strcpy( ctx->errorText, savedText );
+            if ( status != MMB_OK ) strcpy( savedText, ctx->errorText );
+            }
+        }
+    *stop = 0;
+    return status;
+    }
+
+//--- Helper method for prefault mapped file, with time measurement ---
+// INPUT:   ctx = benchmark context
+//          phase = prefault phase
+// OUTPUT:  status, MMB_OK or MMB_ERROR with context errorText
+//---
+static int prefaultPhase( MMB_CONTEXT* ctx, MMB_PHASE* phase )
+    {
+    LARGE_INTEGER frequency, start, stop;
+    WIN32_MEMORY_RANGE_ENTRY range;
+    size_t pages = ( ctx->fileSize + ctx->walkStep - 1 ) / ctx->walkStep;
+    size_t page = 0;
+    volatile char walkData = 0;
+    char* base = (char *) ctx->mapPointer;
+    QueryPerformanceFrequency( &frequency );
+    QueryPerformanceCounter( &start );
+    if ( phase->advice == MMB_ADVICE_WILLNEED )
+        {
+        range.VirtualAddress = ctx->mapPointer;
+        range.NumberOfBytes = ctx->fileSize;
+        if ( PrefetchVirtualMemory( GetCurrentProcess(), 1, &range, 0 ) == 0 )
+            {
+            return setError( ctx, MMB_ERROR, "Error prefetch virtual memory" );
+            }
+        }
+    else
+        {
+        for ( page=0; page<pages; page++ ) walkData = base[page * ctx->walkStep];
+        }
+    QueryPerformanceCounter( &stop );
+    phase->operations = pages;
+    phase->seconds = (double)( stop.QuadPart - start.QuadPart ) / frequency.QuadPart;
+    phase->megabytes = (double)ctx->fileSize / 1048576.0;
+    phase->mbps = phase->megabytes / phase->seconds;
+    return MMB_OK;
+    }
+
+//--- Initialize scenario phase: options defaults from context ---
+// INPUT:   ctx = benchmark context with options
+//          phase = scenario phase for initialize
+//          type = scenario phase type, MMB_SCENARIO_CREATE ... MMB_SCENARIO_DELETE
+//---
+void mmb_phase_init( MMB_CONTEXT* ctx, MMB_PHASE* phase, int type )
+    {
+    memset( phase, 0, sizeof(MMB_PHASE) );
+    phase->type = type;
+    phase->size = ctx->fileSize;
+    phase->alloc = ctx->allocMode;
+    phase->advice = MMB_ADVICE_WILLNEED;
+    phase->threads = 1;
+    phase->pattern = MMB_PATTERN_SEQ;
+    }
+
+//--- Check scenario validity: phases options, file created before access ---
+// INPUT:   ctx = benchmark context with options
+//          phases = array of scenario phases
+//          count = number of scenario phases
+// OUTPUT:  status, MMB_OK or MMB_BAD_PARAMETER with context errorText
+//---
+int mmb_scenario_check( MMB_CONTEXT* ctx, MMB_PHASE phases[], int count )
+    {
+    int created = 0;
+    int i = 0;
+    char s1[PRINT_LIMIT];
+    char s2[PRINT_LIMIT];
+    if ( ctx->fileMode != MMB_MODE_CREATE )
+        {
+        return setError( ctx, MMB_BAD_PARAMETER, "Scenario not compatible with mode %s, scenario creates and deletes file",
+                         mmbModeNames[ctx->fileMode] );
+        }
+    if ( ( count <= 0 ) | ( count > MMB_SCENARIO_MAX ) )
+        {
+        return setError( ctx, MMB_BAD_PARAMETER, "Scenario must have from 1 to %d phases", MMB_SCENARIO_MAX );
+        }
+    if ( ( ctx->walkStep < ctx->pageSize ) | ( ctx->walkStep > STEP_MAX ) )
+        {
+        scratchMemorySize( s1, ctx->pageSize );
+        scratchMemorySize( s2, STEP_MAX );
+        return setError( ctx, MMB_BAD_PARAMETER, "Page walk step must be from page size %s to %s", s1, s2 );
+        }
+    if ( ( ctx->viewOffset != 0 ) | ( ctx->viewAlign != 0 ) | ( ctx->straddleMode != 0 ) )
+        {
+        return setError( ctx, MMB_BAD_PARAMETER, "Scenario maps all file, view offset, align and straddle phase not supported" );
+        }
+    for ( i=0; i<count; i++ )
+        {
+        MMB_PHASE* phase = &phases[i];
+        if ( ( phase->threads < THREADS_MIN ) | ( phase->threads > THREADS_MAX ) )
+            {
+            return setError( ctx, MMB_BAD_PARAMETER, "Phase %d: threads must be from %d to %d", i+1, THREADS_MIN, THREADS_MAX );
+            }
+        if ( ( phase->duration < 0 ) | ( phase->interval < 0 ) )
+            {
+            return setError( ctx, MMB_BAD_PARAMETER, "Phase %d: duration and interval must be non-negative", i+1 );
+            }
+        if ( ( phase->background != 0 ) & ( phase->type != MMB_SCENARIO_READ ) &
+             ( phase->type != MMB_SCENARIO_WRITE ) & ( phase->type != MMB_SCENARIO_FLUSH ) )
+            {
+            return setError( ctx, MMB_BAD_PARAMETER, "Phase %d: only read, write, flush can run in background", i+1 );
+            }
+        switch( phase->type )
+            {
+            case MMB_SCENARIO_CREATE:
+                {
+                if ( created )
+                    {
+                    return setError( ctx, MMB_BAD_PARAMETER, "Phase %d: file already created", i+1 );
+                    }
+                if ( ( phase->size < FILE_SIZE_MIN ) | ( phase->size > FILE_SIZE_MAX ) )
+                    {
+                    scratchMemorySize( s1, FILE_SIZE_MIN );
+                    scratchMemorySize( s2, FILE_SIZE_MAX );
+                    return setError( ctx, MMB_BAD_PARAMETER, "Phase %d: file size must be from %s to %s", i+1, s1, s2 );
+                    }
+                if ( phase->size % ctx->pageSize != 0 )
+                    {
+                    return setError( ctx, MMB_BAD_PARAMETER, "Phase %d: file size must be multiple of page size %d bytes",
+                                     i+1, (int)ctx->pageSize );
+                    }
+                if ( ( ( ctx->targetMode == MMB_TARGET_ANON ) | ( ctx->targetMode == MMB_TARGET_MEMFD ) ) &
+                     ( phase->alloc != MMB_ALLOC_EXTEND ) )
+                    {
+                    return setError( ctx, MMB_BAD_PARAMETER, "Phase %d: target %s has no file blocks, alloc not supported",
+                                     i+1, mmbTargetNames[ctx->targetMode] );
+                    }
+                created = 1;
+                break;
+                }
+            case MMB_SCENARIO_DELETE:
+                {
+                if ( created == 0 ) return setError( ctx, MMB_BAD_PARAMETER, "Phase %d: file not created", i+1 );
+                created = 0;
+                break;
+                }
+            case MMB_SCENARIO_DELAY:
+                {
+                break;
+                }
+            default:
+                {
+                if ( created == 0 ) return setError( ctx, MMB_BAD_PARAMETER, "Phase %d: file not created", i+1 );
+                break;
+                }
+            }
+        }
+    return MMB_OK;
+    }
+
+//--- Run scenario: sequence of phases over one mapped file ---
+// INPUT:   ctx = benchmark context with options, target and path
+//          phases = array of scenario phases, results updated
+//          count = number of scenario phases
+// OUTPUT:  status, MMB_OK or error status with context errorText
+// Background phase runs with next phases, stopped and joined when next
+// foreground phase done, or before create and delete phases, or at scenario end.
+// File kept mapped from create phase to delete phase, shared mapping.
+//---
+int mmb_scenario( MMB_CONTEXT* ctx, MMB_PHASE phases[], int count )
+    {
+    PHASE_RUN* runs = NULL;      // execution state per phase
+    volatile LONG stop = 0;      // stop flag for background phases
+    int status = MMB_OK;
+    int i = 0;
+    status = mmb_scenario_check( ctx, phases, count );
+    if ( status != MMB_OK ) return status;
+    runs = (PHASE_RUN *) calloc( count, sizeof(PHASE_RUN) );
+    if ( runs == NULL ) return setError( ctx, MMB_ERROR, "Error allocate scenario" );
+    ctx->fileFlags = targetFlags[ctx->targetMode];
+    for ( i=0; ( i<count ) && ( status == MMB_OK ); i++ )
+        {
+        MMB_PHASE* phase = &phases[i];
+        runs[i].phase = phase;
+        //--- Background phases stopped before file create and delete ---
+        if ( ( phase->type == MMB_SCENARIO_CREATE ) | ( phase->type == MMB_SCENARIO_DELETE ) )
+            {
+            status = stopPhases( ctx, runs, i, &stop, status );
+            if ( status != MMB_OK ) break;
+            }
+        switch( phase->type )
+            {
+            case MMB_SCENARIO_CREATE:
+                {
+                LARGE_INTEGER frequency, qpc1, qpc2;
+                QueryPerformanceFrequency( &frequency );
+                QueryPerformanceCounter( &qpc1 );
+                ctx->fileSize = phase->size;
+                ctx->allocMode = phase->alloc;
+                status = openView( ctx, fileCreate, PREPARE_ALLOC, MMB_MAPPING_SHARED );
+                QueryPerformanceCounter( &qpc2 );
+                phase->seconds = (double)( qpc2.QuadPart - qpc1.QuadPart ) / frequency.QuadPart;
+                break;
+                }
+            case MMB_SCENARIO_PREFAULT:
+                {
+                status = prefaultPhase( ctx, phase );
+                break;
+                }
+            case MMB_SCENARIO_DELAY:
+                {
+                Sleep( phase->duration );
+                phase->seconds = phase->duration / 1000.0;
+                break;
+                }
+            case MMB_SCENARIO_DELETE:
+                {
+                status = mmb_teardown( ctx );
+                break;
+                }
+            default:
+                {
+                status = startPhase( ctx, &runs[i], &stop );
+                if ( ( status == MMB_OK ) && ( phase->background == 0 ) )
+                    {
+                    status = finishPhase( ctx, &runs[i] );
+                    //--- Background phases stopped when foreground phase done ---
+                    status = stopPhases( ctx, runs, i, &stop, status );
+                    }
+                break;
+                }
+            }
+        }
+    //--- Stop background phases, unmap and delete file if not deleted by scenario ---
+    status = stopPhases( ctx, runs, count, &stop, status );
+    free( runs );
+    if ( ctx->targetExists || ctx->viewOpen )
+        {
+        int teardownStatus = mmb_teardown( ctx );
+        if ( status == MMB_OK ) status = teardownStatus;
+        }
+    return status;
+    }
@@ -0,0 +1,332 @@
+/*
+Memory mapped file io test. (C) IC Book Labs.
+Benchmark library interface: context structure and phase functions.
+All benchmark state located in the MMB_CONTEXT structure, so few contexts can run
+concurrently in one process, except process-wide options:
+pressure and limit (working set size, Linux locked memory limit and cgroup memory.max)
+set by one context at a time, other context with pressure or limit refused until first
+context teardown; counters (perf events inherited by all threads, process page faults
+and times) and read page faults per page (faults/pg) count all threads of process,
+so they include work of other contexts running at same time.
+Typical sequence:
+mmb_init, set context options, mmb_check, mmb_setup,
+for each pass { mmb_write, mmb_read, mmb_punch, mmb_straddle }, mmb_teardown, mmb_stats.
+Scenario sequence:
+mmb_init, set context options, mmb_phase_init and set options for each phase,
+mmb_scenario_check, mmb_scenario.
+Trace replay sequence:
+mmb_init, set context options, mmb_trace_load, set context trace pointer, mmb_check, mmb_setup,
+for each pass { mmb_replay }, mmb_teardown, mmb_stats, mmb_trace_free.
+Existing file startup sequence:
+mmb_init, set context options, optional mmb_hotset_load and set context hotset pointer, mmb_check, mmb_setup,
+for each pass { mmb_startup }, mmb_teardown, mmb_stats, mmb_hotset_free.
+*/
+
+#ifndef MMB_H
+#define MMB_H
+
+#include <stddef.h>
+
+//--- 64-bit platform: Windows x64 or LP64 POSIX ---
+#if defined(_WIN64) || defined(__LP64__)
+#define MMB_64BIT 1
+#else
+#define MMB_64BIT 0
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//--- Limits of public arrays ---
+#define MMB_REPEATS_MAX   100    // maximum number of measurement repeats, size of per pass logs
+#define MMB_SCENARIO_MAX  64     // maximum number of phases in scenario
+
+//--- File blocks allocation modes, index in the mmbAllocNames[] array ---
+#define MMB_ALLOC_EXTEND    0    // file extended by CreateFileMapping, blocks allocated at first write
+#define MMB_ALLOC_SPARSE    1    // sparse file, end of file set but no blocks allocated
+#define MMB_ALLOC_FALLOCATE 2    // blocks reserved by allocation size, data not written
+#define MMB_ALLOC_PREZERO   3    // file fully written with zeroes before mapping
+
+//--- File reuse modes, index in the mmbReuseNames[] array ---
+#define MMB_REUSE_NONE  0    // create, map, unmap and delete file per pass
+#define MMB_REUSE_FILE  1    // create file once, re-open and remap per pass, overwrite in place
+#define MMB_REUSE_VIEW  2    // create file once, file handle, mapping and view kept open across passes
+
+//--- Mapping modes, index in the mmbMappingNames[] array ---
+#define MMB_MAPPING_SHARED    0    // shared read-write mapping, MAP_SHARED
+#define MMB_MAPPING_PRIVATE   1    // private copy-on-write mapping, MAP_PRIVATE
+#define MMB_MAPPING_READONLY  2    // read-only mapping, write-touch phase not supported
+
+//--- Mapping targets, index in the mmbTargetNames[] array ---
+#define MMB_TARGET_FILE   0    // file on storage device, unbuffered write through
+#define MMB_TARGET_ANON   1    // anonymous memory, VirtualAlloc, no backing file
+#define MMB_TARGET_MEMFD  2    // pagefile-backed section, Windows analogue of memfd_create
+#define MMB_TARGET_TMPFS  3    // temporary file, cache manager avoids write back, path can be RAM disk
+#define MMB_TARGET_PMEM   4    // file on DAX volume, persistent memory mapped without page cache
+
+//--- Measured phases, index in the context logs and mmbPhaseNames[] array ---
+#define MMB_WRITE    0    // write phase, durable fill and flush, in-memory fill for anon and memfd, MBPS
+#define MMB_READ     1    // read phase, page walk, MBPS
+#define MMB_TOUCH    2    // write-touch phase, MBPS
+#define MMB_FAULT    3    // write-touch phase, median per-fault latency, microseconds
+#define MMB_REFAULT  4    // punch-hole phase, refault into holes, MBPS
+#define MMB_REPLAY   5    // trace replay phase, MBPS
+#define MMB_P50      6    // trace replay phase, median access latency, microseconds
+#define MMB_P99      7    // trace replay phase, 99th percentile access latency, microseconds
+#define MMB_RFAULTS  8    // read phase, page faults per walked page, under memory pressure or limit
+#define MMB_RP50     9    // rate-limited read phase, median touch latency from intended start, microseconds
+#define MMB_RP99     10   // rate-limited read phase, 99th percentile touch latency from intended start, microseconds
+#define MMB_OPEN     11   // existing file startup, open file, microseconds
+#define MMB_MAP      12   // existing file startup, create mapping object, microseconds
+#define MMB_VIEW     13   // existing file startup, map view, microseconds
+#define MMB_FIRST    14   // existing file startup, touch first pages, microseconds
+#define MMB_STARTUP  15   // existing file startup, open up to first pages touched, microseconds
+#define MMB_HOT      16   // existing file startup, touch hot set offsets after first pages, microseconds
+#define MMB_ALIGNED  17   // straddle phase, median latency of page aligned probe into cold page, microseconds
+#define MMB_STRADDLE 18   // straddle phase, median latency of probe straddling two cold pages, microseconds
+#define MMB_ACHIEVED 19   // rate-limited read phase, achieved rate, completed touches per second
+#define MMB_AFAULTS  20   // straddle phase, page faults per page aligned probe
+#define MMB_SFAULTS  21   // straddle phase, page faults per straddled probe, 2 if both pages cold
+#define MMB_PHASES   22   // number of measured phases
+
+//--- Scenario phase types, index in the mmbScenarioNames[] array ---
+#define MMB_SCENARIO_CREATE    0    // create file and map it, size and alloc options
+#define MMB_SCENARIO_PREFAULT  1    // prefault mapped file, advice option
+#define MMB_SCENARIO_READ      2    // read page walk by threads, pattern and duration options
+#define MMB_SCENARIO_WRITE     3    // write page walk by threads, pattern and duration options
+#define MMB_SCENARIO_FLUSH     4    // flush view by threads, every interval during duration
+#define MMB_SCENARIO_DELAY     5    // wait for duration
+#define MMB_SCENARIO_DELETE    6    // unmap and delete file
+#define MMB_SCENARIO_TYPES     7    // number of scenario phase types
+
+//--- Access patterns for scenario read and write phases, index in the mmbPatternNames[] array ---
+#define MMB_PATTERN_SEQ     0    // sequential page walk, file divided to slices per thread
+#define MMB_PATTERN_RANDOM  1    // random page walk over all file
+
+//--- Prefault advices, index in the mmbAdviceNames[] array ---
+#define MMB_ADVICE_WILLNEED 0    // PrefetchVirtualMemory, means MADV_WILLNEED
+#define MMB_ADVICE_TOUCH    1    // read page walk by one thread
+
+//--- Trace replay modes, index in the mmbReplayNames[] array ---
+#define MMB_REPLAY_OPEN    0    // open-loop, each access issued at recorded time, latency from intended start
+#define MMB_REPLAY_CLOSED  1    // closed-loop, accesses issued as fast as possible, latency from actual start
+
+//--- Write phase flush modes, index in the mmbFlushNames[] array ---
+// All modes end with flush of view and file buffers, fill and flush timed up to durable data.
+#define MMB_FLUSH_SYNC       0    // fill all view, then flush it
+#define MMB_FLUSH_ASYNC      1    // start write back of each chunk after fill it
+#define MMB_FLUSH_PIPELINED  2    // background thread starts write back of filled chunks while next chunk filled
+
+//--- File modes, index in the mmbModeNames[] array ---
+#define MMB_MODE_CREATE    0    // file created, written and deleted by benchmark
+#define MMB_MODE_EXISTING  1    // existing file mapped read-only, not modified and not deleted, size from file
+
+//--- File cache state before existing file startup, index in the mmbCacheNames[] array ---
+#define MMB_CACHE_WARM  0    // file cache as is, cached after first pass
+#define MMB_CACHE_COLD  1    // file cached pages purged before each pass, POSIX only
+
+//--- Sweep modes, index in the mmbSweepNames[] array ---
+#define MMB_SWEEP_OFF     0    // all passes with same rate, balloon and limit
+#define MMB_SWEEP_RATE    1    // pass k reads at rate*(k+1)/repeats, see mmb_rate
+#define MMB_SWEEP_MEMORY  2    // pass k runs with balloon and limit for this pass, see mmb_pressure, mmb_limit
+
+//--- Performance counters, index in the MMB_COUNTERS values[] and mmbCounterNames[] arrays ---
+#define MMB_COUNTER_CYCLES        0    // CPU cycles
+#define MMB_COUNTER_INSTRUCTIONS  1    // retired instructions
+#define MMB_COUNTER_DTLB_MISSES   2    // data TLB misses
+#define MMB_COUNTER_PAGE_WALKS    3    // hardware page table walks
+#define MMB_COUNTER_LLC_MISSES    4    // last level cache misses
+#define MMB_COUNTER_SWITCHES      5    // context switches
+#define MMB_COUNTER_PAGE_FAULTS   6    // page faults
+#define MMB_COUNTER_KERNEL_TIME   7    // kernel mode time, microseconds
+#define MMB_COUNTER_USER_TIME     8    // user mode time, microseconds
+#define MMB_COUNTERS_COUNT        9    // number of counters
+
+//--- Status codes, returned by library functions ---
+#define MMB_OK           0    // operation OK
+#define MMB_BAD_PARAMETER 1   // parameters invalid or not compatible
+#define MMB_ERROR        2    // operating system call failed
+
+#define MMB_ERROR_MAX  160    // maximum length of error description string
+
+//--- Names for options selected from text strings ---
+extern char* mmbAllocNames[];
+extern char* mmbPunchNames[];
+extern char* mmbReuseNames[];
+extern char* mmbMappingNames[];
+extern char* mmbTargetNames[];
+extern char* mmbPhaseNames[];
+extern char* mmbScenarioNames[];
+extern char* mmbPatternNames[];
+extern char* mmbAdviceNames[];
+extern char* mmbReplayNames[];
+extern char* mmbCountersNames[];
+extern char* mmbCounterNames[];
+extern char* mmbFlushNames[];
+extern char* mmbSweepNames[];
+extern char* mmbModeNames[];
+extern char* mmbCacheNames[];
+extern char* mmbStraddleNames[];
+extern char* mmbTouchNames[];
+
+//--- Performance counters values for one timed region ---
+// Windows has no documented access to hardware events without driver, so process-wide
+// cycles (QueryProcessCycleTime), page faults (GetProcessMemoryInfo) and kernel and user
+// times (GetProcessTimes) collected, other counters not valid.
+typedef struct
+    {
+    double values[MMB_COUNTERS_COUNT];   // counters increments at timed region
+    unsigned int valid;              // bit mask of collected counters, bit number = counter index
+    } MMB_COUNTERS;
+
+//--- Trace record: one recorded access ---
+typedef struct
+    {
+    unsigned long long offset;   // offset in file, bytes
+    unsigned long long time;     // intended start from replay start, microseconds, sum of recorded deltas
+    unsigned int length;         // access length, bytes
+    unsigned short thread;       // recorded thread number, replayed by same number thread
+    unsigned char write;         // 0 = read access, 1 = write access
+    } MMB_RECORD;
+
+//--- Trace: recorded accesses sequence, loaded by mmb_trace_load ---
+typedef struct
+    {
+    MMB_RECORD* records;         // array of records, in recorded order
+    size_t count;                // number of records
+    int threads;                 // number of threads, maximum thread number + 1
+    size_t span;                 // file size required for replay, bytes, page multiple
+    double* latencies;           // per record access latency of last replay pass, microseconds
+    } MMB_TRACE;
+
+//--- Hot set: offsets touched at startup of existing file, loaded by mmb_hotset_load ---
+typedef struct
+    {
+    unsigned long long* offsets;   // array of offsets in file, bytes, in listed order
+    size_t count;                  // number of offsets
+    unsigned long long maximum;    // maximum offset, must be below file size
+    } MMB_HOTSET;
+
+//--- Benchmark context: options, operating system objects, results ---
+// Size is about 170 KB, most of it per pass logs and counters arrays,
+// context must be static or allocated by malloc, not local variable on stack.
+typedef struct
+    {
+    //--- Options, set by mmb_init to defaults, can be changed before mmb_check ---
+    char*   filePath;                // pointer to file path string
+    size_t  fileSize;                // file size, bytes
+    int     writeDelay;              // delay from start to write, milliseconds
+    int     readDelay;               // delay from write end to read, milliseconds
+    int     repeats;                 // number of times to repeat test, for measurement precision
+    int     allocMode;               // file blocks allocation mode before mapping
+    int     punchMode;               // punch-hole and refault phase, 0=off, 1=on
+    int     reuseMode;               // file reuse between passes: none, file, or file and view
+    int     mappingMode;             // mapping mode for read and write-touch phases
+    int     targetMode;              // mapping target: file, anonymous memory, section, tmp or DAX file
+    int     replayMode;              // trace replay mode, open-loop or closed-loop
+    MMB_TRACE* trace;                // loaded trace, NULL means no trace replay, passes run write and read phases
+    int     countersMode;            // performance counters around timed regions, 0=off, 1=on
+    int     flushMode;               // write phase flush mode: sync, async or pipelined
+    size_t  flushChunk;              // chunk size for async and pipelined flush modes, bytes
+    size_t  pressureSize;            // locked balloon size, bytes, 0=no memory pressure
+    size_t  memoryLimit;             // hard working set limit, bytes, 0=no limit
+    int     touchRate;               // read walk rate, pages per second, 0=closed-loop walk
+    int     sweepMode;               // sweep of read walk rate or of balloon and limit over passes
+    int     touchMode;               // write-touch for shared mapping as dirty fault reference, 0=off, 1=on
+    int     fileMode;                // create file, or map existing file read-only
+    int     firstPages;              // existing file: number of first pages touched at startup
+    int     cacheMode;               // existing file: file cache warm or purged before each pass
+    MMB_HOTSET* hotset;              // existing file: loaded hot set, NULL means no hot set
+    size_t  walkStep;                // page walk step, bytes, set by mmb_init to system page size
+    size_t  viewOffset;              // view offset in file, bytes, multiple of allocation granularity
+    size_t  viewAlign;               // walk start displacement from view start, bytes, below page size
+    int     straddleMode;            // page-straddling probe phase, 0=off, 1=on
+    //--- System parameters, detected by mmb_init ---
+    size_t  pageSize;                // virtual memory page size, bytes
+    size_t  granularity;             // view offset granularity, bytes, 64K on Windows, page size on POSIX
+    //--- Operating system objects ---
+    void*   fileHandle;              // file handle, result of CreateFile
+    unsigned long fileFlags;               // file attributes, selected by target
+    void*   mapHandle;               // mapping handle, result of CreateFileMapping
+    void*   sectionHandle;           // pagefile-backed section handle, lives from create to delete
+    void*   mapPointer;              // virtual address of mapping view, result of MapViewOfFile
+    int     viewOpen;                // 1 means view mapped now
+    int     targetExists;            // 1 means file or section created and not deleted yet
+    void*   balloonPointer;          // locked balloon, result of VirtualAlloc, NULL if not allocated
+    size_t  balloonSize;             // locked balloon size for current pass, bytes
+    int     limitsSet;               // 1 means working set size changed, restore at teardown
+    size_t  savedMinimum;            // working set minimum before setup
+    size_t  savedMaximum;            // working set maximum before setup
+    int     perfEvents[MMB_COUNTERS_COUNT];   // Linux perf events descriptors, opened by setup if counters on, -1 if not
+    //--- Results ---
+    double  logs[MMB_PHASES][MMB_REPEATS_MAX];   // arrays of results per phase, per pass
+    MMB_COUNTERS counters[MMB_PHASES][MMB_REPEATS_MAX];   // performance counters per phase, per pass, if enabled
+    char    errorText[MMB_ERROR_MAX];        // description of last error
+    } MMB_CONTEXT;
+
+//--- Statistics for one phase ---
+typedef struct
+    {
+    double median;      // median speed, megabytes per second
+    double average;     // average speed, megabytes per second
+    double minimum;     // minimum detected speed, megabytes per second
+    double maximum;     // maximum detected speed, megabytes per second
+    } MMB_STATS;
+
+//--- Scenario phase: options and results ---
+typedef struct
+    {
+    //--- Options, set by mmb_phase_init to defaults ---
+    int     type;         // scenario phase type, MMB_SCENARIO_CREATE ... MMB_SCENARIO_DELETE
+    size_t  size;         // create: file size, bytes
+    int     alloc;        // create: file blocks allocation mode
+    int     advice;       // prefault: advice, MMB_ADVICE_WILLNEED or MMB_ADVICE_TOUCH
+    int     threads;      // read, write, flush: number of threads
+    int     pattern;      // read, write: access pattern, MMB_PATTERN_SEQ or MMB_PATTERN_RANDOM
+    int     duration;     // read, write, flush, delay: duration in milliseconds, 0 means one walk over file
+    int     interval;     // flush: interval between flushes in milliseconds
+    int     background;   // 1 means phase runs with next phases, up to next foreground phase done
+    //--- Results, set by mmb_scenario ---
+    double  seconds;      // phase duration, seconds
+    double  megabytes;    // processed data, touched pages multiply page size, megabytes
+    double  mbps;         // megabytes per second
+    long long operations; // number of touched pages or flushes
+    } MMB_PHASE;
+
+//--- Phase functions, return MMB_OK or error status with context errorText ---
+void mmb_init( MMB_CONTEXT* ctx );
+int  mmb_check( MMB_CONTEXT* ctx );
+int  mmb_setup( MMB_CONTEXT* ctx );
+int  mmb_write( MMB_CONTEXT* ctx, int pass );
+int  mmb_read( MMB_CONTEXT* ctx, int pass );
+int  mmb_punch( MMB_CONTEXT* ctx, int pass );
+int  mmb_straddle( MMB_CONTEXT* ctx, int pass );
+int  mmb_teardown( MMB_CONTEXT* ctx );
+int  mmb_enabled( MMB_CONTEXT* ctx, int phase );
+void mmb_stats( MMB_CONTEXT* ctx, int phase, int count, MMB_STATS* stats );
+int  mmb_counted( MMB_CONTEXT* ctx, int phase );
+int  mmb_rate( MMB_CONTEXT* ctx, int pass );
+size_t mmb_pressure( MMB_CONTEXT* ctx, int pass );
+size_t mmb_limit( MMB_CONTEXT* ctx, int pass );
+
+//--- Trace replay functions ---
+int  mmb_trace_load( MMB_CONTEXT* ctx, char* path, MMB_TRACE* trace );
+void mmb_trace_free( MMB_TRACE* trace );
+int  mmb_replay( MMB_CONTEXT* ctx, int pass );
+
+//--- Existing file startup functions ---
+int  mmb_hotset_load( MMB_CONTEXT* ctx, char* path, MMB_HOTSET* hotset );
+void mmb_hotset_free( MMB_HOTSET* hotset );
+int  mmb_startup( MMB_CONTEXT* ctx, int pass );
+
+//--- Scenario functions ---
+void mmb_phase_init( MMB_CONTEXT* ctx, MMB_PHASE* phase, int type );
+int  mmb_scenario_check( MMB_CONTEXT* ctx, MMB_PHASE phases[], int count );
+int  mmb_scenario( MMB_CONTEXT* ctx, MMB_PHASE phases[], int count );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // MMB_H
@@ -0,0 +1,1011 @@
+/*
+Memory mapped file io test. (C) IC Book Labs.
+POSIX port layer implementation, see mmb_posix.h.
+Only Win32 API semantics used by benchmark library supported.
+*/
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <mntent.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/types.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <sys/ioctl.h>
+#include <dirent.h>
+#include <linux/falloc.h>
+#include <linux/perf_event.h>
+#include "mmb_posix.h"
+
+//--- Handle object types ---
+#define OBJECT_FILE       1    // file descriptor
+#define OBJECT_MAPPING    2    // mapping object: descriptor duplicate and size
+#define OBJECT_THREAD     3    // pthread
+#define OBJECT_SEMAPHORE  4    // unnamed semaphore
+
+//--- Handle object, one structure for all object types ---
+typedef struct
+    {
+    int type;                         // object type, OBJECT_FILE ... OBJECT_SEMAPHORE
+    int fd;                           // file: file descriptor, mapping: descriptor of file or memfd
+    size_t size;                      // mapping: mapping size, bytes
+    pthread_t thread;                 // thread: pthread identifier
+    int joined;                       // thread: 1 means pthread_join done
+    LPTHREAD_START_ROUTINE routine;   // thread: Win32-style thread routine
+    LPVOID parm;                      // thread: routine parameter
+    sem_t semaphore;                  // semaphore
+    } OBJECT;
+
+//--- Views and virtual allocations, munmap requires size but Win32 release by base address ---
+#define REGIONS_MAX  1024
+typedef struct
+    {
+    void* base;     // address returned by mmap, NULL means free entry
+    size_t size;    // mapped size, bytes
+    } REGION;
+static REGION regions[REGIONS_MAX];
+static pthread_mutex_t regionsLock = PTHREAD_MUTEX_INITIALIZER;
+
+//--- Cgroup memory limit, set for child cgroup created for run, other processes of current cgroup not limited ---
+#define CGROUP_ROOT  "/sys/fs/cgroup"
+#define CGROUP_LINE  512
+#define CGROUP_RUN   "mapfile-"         // run cgroup name prefix, process id appended
+static char cgroupParent[PATH_MAX];     // cgroup of process before move to run cgroup, empty if not moved
+static char cgroupRun[PATH_MAX];        // run cgroup, created at first limit, removed when limit disabled
+static int cgroupMemory = 0;            // 1 means memory controller enabled in parent subtree by benchmark
+
+//--- Perf events sysfs directory, PMU aliases for raw events ---
+#define PERF_SYSFS  "/sys/bus/event_source/devices"
+
+//---------- Helpers -----------------------------------------------------------
+
+//--- Helper method for allocate handle object ---
+// INPUT:   type = object type
+// OUTPUT:  object pointer, NULL if allocation error
+//---
+static OBJECT* newObject( int type )
+    {
+    OBJECT* object = (OBJECT *) calloc( 1, sizeof(OBJECT) );
+    if ( object != NULL )
+        {
+        object->type = type;
+        object->fd = -1;
+        }
+    return object;
+    }
+
+//--- Helper method for get file descriptor of file handle ---
+// INPUT:   handle = file handle
+// OUTPUT:  file descriptor, -1 if handle is not file
+//---
+static int fileDescriptor( HANDLE handle )
+    {
+    OBJECT* object = (OBJECT *) handle;
+    if ( ( object == NULL ) || ( handle == INVALID_HANDLE_VALUE ) || ( object->type != OBJECT_FILE ) ) return -1;
+    return object->fd;
+    }
+
+//--- Helper method for register mapped region ---
+// INPUT:   base = region address
+//          size = region size, bytes
+// OUTPUT:  1 = registered, 0 = table full
+//---
+static int addRegion( void* base, size_t size )
+    {
+    int i = 0;
+    int status = 0;
+    pthread_mutex_lock( &regionsLock );
+    for ( i=0; i<REGIONS_MAX; i++ )
+        {
+        if ( regions[i].base == NULL )
+            {
+            regions[i].base = base;
+            regions[i].size = size;
+            status = 1;
+            break;
+            }
+        }
+    pthread_mutex_unlock( &regionsLock );
+    return status;
+    }
+
+//--- Helper method for find and optionally unregister mapped region ---
+// INPUT:   base = region address
+//          remove = 1 means unregister found region
+// OUTPUT:  region size, 0 if not found
+//---
+static size_t findRegion( const void* base, int remove )
+    {
+    int i = 0;
+    size_t size = 0;
+    pthread_mutex_lock( &regionsLock );
+    for ( i=0; i<REGIONS_MAX; i++ )
+        {
+        if ( ( regions[i].base != NULL ) && ( regions[i].base == base ) )
+            {
+            size = regions[i].size;
+            if ( remove ) regions[i].base = NULL;
+            break;
+            }
+        }
+    pthread_mutex_unlock( &regionsLock );
+    return size;
+    }
+
+//--- Helper method for align range to page boundaries, required by msync and madvise ---
+// INPUT:   base = range start
+//          size = range size, bytes
+//          alignedSize = pointer for aligned size
+// OUTPUT:  aligned range start
+//---
+static void* alignRange( const void* base, size_t size, size_t* alignedSize )
+    {
+    uintptr_t page = (uintptr_t) sysconf( _SC_PAGESIZE );
+    uintptr_t start = (uintptr_t) base & ~( page - 1 );
+    *alignedSize = size + ( (uintptr_t) base - start );
+    return (void *) start;
+    }
+
+//--- Helper method for convert timeval to FILETIME, 100 ns units ---
+static void timevalToFiletime( struct timeval* tv, LPFILETIME ft )
+    {
+    unsigned long long units = (unsigned long long) tv->tv_sec * 10000000ULL + tv->tv_usec * 10ULL;
+    ft->dwLowDateTime = (DWORD) units;
+    ft->dwHighDateTime = (DWORD)( units >> 32 );
+    }
+
+//--- Helper method for build path of current cgroup v2 directory ---
+// INPUT:   path = buffer for path, PATH_MAX chars
+// OUTPUT:  1 = path built, 0 = cgroup v2 not detected
+//---
+static int cgroupPath( char* path )
+    {
+    char line[CGROUP_LINE];
+    int found = 0;
+    FILE* f = fopen( "/proc/self/cgroup", "rt" );
+    if ( f == NULL ) return 0;
+    while ( fgets( line, CGROUP_LINE, f ) != NULL )
+        {
+        if ( strncmp( line, "0::", 3 ) == 0 )
+            {
+            line[strcspn( line, "\n" )] = 0;
+            snprintf( path, PATH_MAX, "%s%s", CGROUP_ROOT, ( strcmp( line + 3, "/" ) == 0 ) ? "" : line + 3 );
+            found = 1;
+            break;
+            }
+        }
+    fclose( f );
+    return found;
+    }
+
+//--- Helper method for write string to file, cgroup control files ---
+// OUTPUT:  1 = OK, 0 = error
+//---
+static int writeString( const char* path, const char* text )
+    {
+    int status = 0;
+    FILE* f = fopen( path, "wt" );
+    if ( f == NULL ) return 0;
+    status = fputs( text, f ) >= 0;
+    if ( fclose( f ) != 0 ) status = 0;
+    return status;
+    }
+
+//--- Helper method for move this process to cgroup ---
+// INPUT:   cgroup = cgroup directory
+// OUTPUT:  1 = OK, 0 = error
+//---
+static int cgroupMove( const char* cgroup )
+    {
+    char path[PATH_MAX];
+    char line[CGROUP_LINE];
+    snprintf( path, PATH_MAX, "%s/cgroup.procs", cgroup );
+    snprintf( line, CGROUP_LINE, "%d\n", (int) getpid() );
+    return writeString( path, line );
+    }
+
+//--- Helper method for create run cgroup under current cgroup and move this process to it ---
+// Current cgroup must be delegated to user and contain no other processes, because memory
+// controller can be enabled for children only when parent has no processes, for example
+// started by systemd-run --user --scope -p Delegate=yes. Otherwise refused, limit not set.
+// If process killed before limit disabled, empty run cgroup remains and limits nothing.
+// OUTPUT:  1 = OK, process in run cgroup with memory controller, 0 = error
+//---
+static int cgroupCreate( void )
+    {
+    char path[PATH_MAX];
+    char line[CGROUP_LINE];
+    FILE* f = NULL;
+    if ( cgroupPath( cgroupParent ) == 0 ) return 0;
+    snprintf( path, PATH_MAX, "%s/cgroup.subtree_control", cgroupParent );
+    if ( ( access( path, W_OK ) != 0 ) || ( strcmp( cgroupParent, CGROUP_ROOT ) == 0 ) )
+        {
+        cgroupParent[0] = 0;
+        return 0;    // not delegated, or root cgroup limits all system
+        }
+    snprintf( cgroupRun, PATH_MAX, "%s/%s%d", cgroupParent, CGROUP_RUN, (int) getpid() );
+    if ( ( mkdir( cgroupRun, 0755 ) != 0 ) && ( errno != EEXIST ) )
+        {
+        cgroupParent[0] = 0;
+        cgroupRun[0] = 0;
+        return 0;
+        }
+    if ( cgroupMove( cgroupRun ) == 0 )
+        {
+        rmdir( cgroupRun );
+        cgroupParent[0] = 0;
+        cgroupRun[0] = 0;
+        return 0;
+        }
+    line[0] = 0;
+    if ( ( f = fopen( path, "rt" ) ) != NULL )
+        {
+        if ( fgets( line, CGROUP_LINE, f ) == NULL ) line[0] = 0;
+        fclose( f );
+        }
+    if ( strstr( line, "memory" ) == NULL )
+        {
+        if ( writeString( path, "+memory" ) == 0 )    // fails if other processes left in parent
+            {
+            cgroupMove( cgroupParent );
+            rmdir( cgroupRun );
+            cgroupParent[0] = 0;
+            cgroupRun[0] = 0;
+            return 0;
+            }
+        cgroupMemory = 1;
+        }
+    return 1;
+    }
+
+//--- Helper method for move this process back to parent cgroup and remove run cgroup ---
+// OUTPUT:  1 = OK, 0 = error
+//---
+static int cgroupRemove( void )
+    {
+    char path[PATH_MAX];
+    int status = cgroupMove( cgroupParent );
+    if ( status && ( rmdir( cgroupRun ) != 0 ) ) status = 0;
+    if ( status && cgroupMemory )
+        {
+        snprintf( path, PATH_MAX, "%s/cgroup.subtree_control", cgroupParent );
+        writeString( path, "-memory" );    // can fail if memory used by other children, ignored
+        }
+    cgroupParent[0] = 0;
+    cgroupRun[0] = 0;
+    cgroupMemory = 0;
+    return status;
+    }
+
+//--- Helper method for thread start, calls Win32-style routine ---
+static void* threadStart( void* parm )
+    {
+    OBJECT* object = (OBJECT *) parm;
+    object->routine( object->parm );
+    return NULL;
+    }
+
+//---------- Files -------------------------------------------------------------
+
+HANDLE CreateFile( LPCTSTR path, DWORD access, DWORD share, LPSECURITY_ATTRIBUTES security,
+                   DWORD disposition, DWORD flags, HANDLE templateFile )
+    {
+    OBJECT* object = NULL;
+    int oflags = O_CLOEXEC;
+    oflags |= ( access & GENERIC_WRITE ) ? O_RDWR : O_RDONLY;
+    if ( disposition == CREATE_ALWAYS ) oflags |= O_CREAT | O_TRUNC;
+    if ( disposition == OPEN_ALWAYS ) oflags |= O_CREAT;
+    object = newObject( OBJECT_FILE );
+    if ( object == NULL ) return INVALID_HANDLE_VALUE;
+    object->fd = open( path, oflags, 0644 );
+    if ( object->fd < 0 )
+        {
+        free( object );
+        return INVALID_HANDLE_VALUE;
+        }
+    //--- Unbuffered open keeps cached pages of file, Windows unbuffered open does not evict them, see PurgeFileCache ---
+    if ( flags & FILE_FLAG_SEQUENTIAL_SCAN ) posix_fadvise( object->fd, 0, 0, POSIX_FADV_SEQUENTIAL );
+    return (HANDLE) object;
+    }
+
+BOOL WriteFile( HANDLE hFile, LPCVOID buffer, DWORD size, LPDWORD written, LPOVERLAPPED overlapped )
+    {
+    int fd = fileDescriptor( hFile );
+    const char* p = (const char *) buffer;
+    DWORD total = 0;
+    ssize_t n = 0;
+    while ( total < size )
+        {
+        n = write( fd, p + total, size - total );
+        if ( n < 0 )
+            {
+            if ( errno == EINTR ) continue;
+            break;
+            }
+        total += (DWORD) n;
+        }
+    if ( written != NULL ) *written = total;
+    return total == size;
+    }
+
+BOOL SetFilePointerEx( HANDLE hFile, LARGE_INTEGER distance, PLARGE_INTEGER position, DWORD method )
+    {
+    off_t result = lseek( fileDescriptor( hFile ), (off_t) distance.QuadPart, method == FILE_BEGIN ? SEEK_SET : SEEK_CUR );
+    if ( result < 0 ) return FALSE;
+    if ( position != NULL ) position->QuadPart = result;
+    return TRUE;
+    }
+
+BOOL SetEndOfFile( HANDLE hFile )
+    {
+    int fd = fileDescriptor( hFile );
+    off_t position = lseek( fd, 0, SEEK_CUR );
+    if ( position < 0 ) return FALSE;
+    return ftruncate( fd, position ) == 0;
+    }
+
+BOOL SetFileInformationByHandle( HANDLE hFile, FILE_INFO_BY_HANDLE_CLASS infoClass, LPVOID info, DWORD size )
+    {
+    FILE_ALLOCATION_INFO* allocInfo = (FILE_ALLOCATION_INFO *) info;
+    if ( infoClass != FileAllocationInfo ) return FALSE;
+    return fallocate( fileDescriptor( hFile ), FALLOC_FL_KEEP_SIZE, 0, (off_t) allocInfo->AllocationSize.QuadPart ) == 0;
+    }
+
+BOOL DeviceIoControl( HANDLE hFile, DWORD code, LPVOID in, DWORD inSize, LPVOID out, DWORD outSize,
+                      LPDWORD returned, LPOVERLAPPED overlapped )
+    {
+    FILE_ZERO_DATA_INFORMATION* zeroInfo = (FILE_ZERO_DATA_INFORMATION *) in;
+    if ( returned != NULL ) *returned = 0;
+    switch( code )
+        {
+        case FSCTL_SET_SPARSE:
+            return fileDescriptor( hFile ) >= 0;
+        case FSCTL_SET_ZERO_DATA:
+            return fallocate( fileDescriptor( hFile ), FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE,
+                              (off_t) zeroInfo->FileOffset.QuadPart,
+                              (off_t)( zeroInfo->BeyondFinalZero.QuadPart - zeroInfo->FileOffset.QuadPart ) ) == 0;
+        }
+    return FALSE;
+    }
+
+BOOL FlushFileBuffers( HANDLE hFile )
+    {
+    return fsync( fileDescriptor( hFile ) ) == 0;
+    }
+
+BOOL DeleteFile( LPCTSTR path )
+    {
+    return unlink( path ) == 0;
+    }
+
+BOOL GetFileAttributesEx( LPCTSTR path, GET_FILEEX_INFO_LEVELS level, LPVOID info )
+    {
+    WIN32_FILE_ATTRIBUTE_DATA* data = (WIN32_FILE_ATTRIBUTE_DATA *) info;
+    struct stat st;
+    if ( stat( path, &st ) != 0 ) return FALSE;
+    memset( data, 0, sizeof(WIN32_FILE_ATTRIBUTE_DATA) );
+    data->dwFileAttributes = FILE_ATTRIBUTE_NORMAL;
+    data->nFileSizeLow = (DWORD) st.st_size;
+    data->nFileSizeHigh = (DWORD)( (unsigned long long) st.st_size >> 32 );
+    return TRUE;
+    }
+
+//--- Volume path is file path, volume detected by GetVolumeInformation ---
+BOOL GetVolumePathName( LPCTSTR path, LPSTR volumePath, DWORD size )
+    {
+    if ( strlen( path ) >= size ) return FALSE;
+    strcpy( volumePath, path );
+    return TRUE;
+    }
+
+//--- Volume flags: DAX if file system containing path mounted with dax option ---
+BOOL GetVolumeInformation( LPCTSTR root, LPSTR name, DWORD nameSize, LPDWORD serial, LPDWORD maxLength,
+                           LPDWORD flags, LPSTR fsName, DWORD fsNameSize )
+    {
+    char path[PATH_MAX];
+    char resolved[PATH_MAX];
+    char* slash = NULL;
+    size_t bestLength = 0;
+    int dax = 0;
+    FILE* mounts = NULL;
+    struct mntent* entry = NULL;
+    //--- Resolve path, file can be not created yet, then resolve directory ---
+    if ( realpath( root, resolved ) == NULL )
+        {
+        snprintf( path, PATH_MAX, "%s", root );
+        slash = strrchr( path, '/' );
+        if ( slash == NULL ) strcpy( path, "." );
+        else if ( slash == path ) path[1] = 0;
+        else *slash = 0;
+        if ( realpath( path, resolved ) == NULL ) return FALSE;
+        }
+    //--- Longest mount point prefix is file system containing path ---
+    mounts = setmntent( "/proc/self/mounts", "r" );
+    if ( mounts == NULL ) return FALSE;
+    while ( ( entry = getmntent( mounts ) ) != NULL )
+        {
+        size_t length = strlen( entry->mnt_dir );
+        if ( ( strncmp( resolved, entry->mnt_dir, length ) == 0 ) &&
+             ( ( resolved[length] == '/' ) || ( resolved[length] == 0 ) || ( length == 1 ) ) &&
+             ( length >= bestLength ) )
+            {
+            bestLength = length;
+            dax = hasmntopt( entry, "dax" ) != NULL;
+            }
+        }
+    endmntent( mounts );
+    if ( flags != NULL ) *flags = dax ? FILE_DAX_VOLUME : 0;
+    return TRUE;
+    }
+
+//---------- Mappings and memory -----------------------------------------------
+
+//--- File mapping extends file if mapping size above file size, as Windows does for writable mapping ---
+// Invalid file handle means pagefile-backed section, memfd is Linux analogue.
+//---
+HANDLE CreateFileMapping( HANDLE hFile, LPSECURITY_ATTRIBUTES security, DWORD protect,
+                          DWORD sizeHigh, DWORD sizeLow, LPCTSTR name )
+    {
+    OBJECT* object = newObject( OBJECT_MAPPING );
+    struct stat st;
+    size_t size = ( (size_t) sizeHigh << 32 ) | sizeLow;
+    if ( object == NULL ) return NULL;
+    if ( hFile == INVALID_HANDLE_VALUE )
+        {
+        object->fd = memfd_create( "mmb", MFD_CLOEXEC );
+        if ( ( object->fd >= 0 ) && ( ftruncate( object->fd, (off_t) size ) != 0 ) )
+            {
+            close( object->fd );
+            object->fd = -1;
+            }
+        }
+    else if ( fileDescriptor( hFile ) >= 0 )
+        {
+        object->fd = fcntl( fileDescriptor( hFile ), F_DUPFD_CLOEXEC, 0 );
+        if ( ( object->fd >= 0 ) && ( fstat( object->fd, &st ) == 0 ) )
+            {
+            if ( size == 0 )
+                {
+                size = (size_t) st.st_size;
+                }
+            else if ( (size_t) st.st_size < size )
+                {
+                if ( ( ( protect & 0xFF ) != PAGE_READWRITE ) || ( ftruncate( object->fd, (off_t) size ) != 0 ) )
+                    {
+                    close( object->fd );
+                    object->fd = -1;
+                    }
+                }
+            }
+        }
+    if ( ( object->fd < 0 ) || ( size == 0 ) )
+        {
+        if ( object->fd >= 0 ) close( object->fd );
+        free( object );
+        return NULL;
+        }
+    object->size = size;
+    return (HANDLE) object;
+    }
+
+LPVOID MapViewOfFile( HANDLE hMapping, DWORD access, DWORD offsetHigh, DWORD offsetLow, SIZE_T size )
+    {
+    OBJECT* object = (OBJECT *) hMapping;
+    size_t offset = ( (size_t) offsetHigh << 32 ) | offsetLow;
+    int prot = PROT_READ | PROT_WRITE;
+    int flags = MAP_SHARED;
+    void* base = NULL;
+    if ( ( object == NULL ) || ( object->type != OBJECT_MAPPING ) || ( offset >= object->size ) ) return NULL;
+    if ( size == 0 ) size = object->size - offset;
+    if ( access == FILE_MAP_COPY ) flags = MAP_PRIVATE;
+    else if ( access == FILE_MAP_READ ) prot = PROT_READ;
+    base = mmap( NULL, size, prot, flags, object->fd, (off_t) offset );
+    if ( base == MAP_FAILED ) return NULL;
+    if ( addRegion( base, size ) == 0 )
+        {
+        munmap( base, size );
+        return NULL;
+        }
+    return base;
+    }
+
+BOOL UnmapViewOfFile( LPCVOID base )
+    {
+    size_t size = findRegion( base, 1 );
+    if ( size == 0 ) return FALSE;
+    return munmap( (void *) base, size ) == 0;
+    }
+
+//--- Flush waits for write back, same as FlushViewOfFile issues and waits writes to device ---
+BOOL FlushViewOfFile( LPCVOID base, SIZE_T size )
+    {
+    size_t alignedSize = 0;
+    void* aligned = NULL;
+    if ( size == 0 ) size = findRegion( base, 0 );
+    aligned = alignRange( base, size, &alignedSize );
+    return msync( aligned, alignedSize, MS_SYNC ) == 0;
+    }
+
+LPVOID VirtualAlloc( LPVOID address, SIZE_T size, DWORD type, DWORD protect )
+    {
+    void* base = mmap( address, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0 );
+    if ( base == MAP_FAILED ) return NULL;
+    if ( addRegion( base, size ) == 0 )
+        {
+        munmap( base, size );
+        return NULL;
+        }
+    return base;
+    }
+
+BOOL VirtualFree( LPVOID address, SIZE_T size, DWORD type )
+    {
+    size_t regionSize = findRegion( address, 1 );
+    if ( regionSize == 0 ) return FALSE;
+    return munmap( address, regionSize ) == 0;
+    }
+
+BOOL VirtualLock( LPVOID address, SIZE_T size )
+    {
+    return mlock( address, size ) == 0;
+    }
+
+BOOL VirtualUnlock( LPVOID address, SIZE_T size )
+    {
+    return munlock( address, size ) == 0;
+    }
+
+BOOL PrefetchVirtualMemory( HANDLE hProcess, ULONG_PTR count, PWIN32_MEMORY_RANGE_ENTRY ranges, ULONG flags )
+    {
+    ULONG_PTR i = 0;
+    size_t alignedSize = 0;
+    void* aligned = NULL;
+    for ( i=0; i<count; i++ )
+        {
+        aligned = alignRange( ranges[i].VirtualAddress, ranges[i].NumberOfBytes, &alignedSize );
+        if ( madvise( aligned, alignedSize, MADV_WILLNEED ) != 0 ) return FALSE;
+        }
+    return TRUE;
+    }
+
+//---------- Process -----------------------------------------------------------
+
+HANDLE GetCurrentProcess( void )
+    {
+    return INVALID_HANDLE_VALUE;    // pseudo handle, same value as Windows
+    }
+
+//--- Page size is runtime value: 4K on x86, 4K, 16K or 64K on ARM64, mmap offset must be page multiple ---
+void GetSystemInfo( LPSYSTEM_INFO info )
+    {
+    long page = sysconf( _SC_PAGESIZE );
+    long cpus = sysconf( _SC_NPROCESSORS_ONLN );
+    memset( info, 0, sizeof(SYSTEM_INFO) );
+    if ( page <= 0 ) page = 4096;
+    if ( cpus <= 0 ) cpus = 1;
+    info->dwPageSize = (DWORD) page;
+    info->dwAllocationGranularity = (DWORD) page;
+    info->dwNumberOfProcessors = (DWORD) cpus;
+    info->lpMinimumApplicationAddress = (LPVOID)(uintptr_t) page;
+    info->lpMaximumApplicationAddress = (LPVOID)(uintptr_t) -1;
+    }
+
+//--- Working set minimum is locked memory limit, maximum is memory.max of current cgroup ---
+BOOL GetProcessWorkingSetSize( HANDLE hProcess, PSIZE_T minimum, PSIZE_T maximum )
+    {
+    char path[PATH_MAX];
+    char line[CGROUP_LINE];
+    struct rlimit limit;
+    FILE* f = NULL;
+    if ( getrlimit( RLIMIT_MEMLOCK, &limit ) != 0 ) return FALSE;
+    *minimum = ( limit.rlim_cur == RLIM_INFINITY ) ? SIZE_MAX : (SIZE_T) limit.rlim_cur;
+    *maximum = SIZE_MAX;
+    if ( cgroupPath( path ) )
+        {
+        strncat( path, "/memory.max", PATH_MAX - strlen( path ) - 1 );
+        if ( ( f = fopen( path, "rt" ) ) != NULL )
+            {
+            if ( ( fgets( line, CGROUP_LINE, f ) != NULL ) && ( strncmp( line, "max", 3 ) != 0 ) )
+                {
+                *maximum = (SIZE_T) strtoull( line, NULL, 10 );
+                }
+            fclose( f );
+            }
+        }
+    return TRUE;
+    }
+
+//--- Minimum sets locked memory limit, for lock balloon ---
+// Hard maximum creates run cgroup at first enable, see cgroupCreate, and writes its memory.max,
+// so only this process limited. Disable moves process back and removes run cgroup.
+//---
+BOOL SetProcessWorkingSetSizeEx( HANDLE hProcess, SIZE_T minimum, SIZE_T maximum, DWORD flags )
+    {
+    char path[PATH_MAX];
+    char line[CGROUP_LINE];
+    struct rlimit limit;
+    if ( getrlimit( RLIMIT_MEMLOCK, &limit ) != 0 ) return FALSE;
+    limit.rlim_cur = ( minimum == SIZE_MAX ) ? RLIM_INFINITY : (rlim_t) minimum;
+    if ( ( limit.rlim_max != RLIM_INFINITY ) && ( limit.rlim_cur > limit.rlim_max ) ) limit.rlim_max = limit.rlim_cur;
+    if ( setrlimit( RLIMIT_MEMLOCK, &limit ) != 0 ) return FALSE;
+    if ( flags & QUOTA_LIMITS_HARDWS_MAX_ENABLE )
+        {
+        if ( ( cgroupRun[0] == 0 ) && ( cgroupCreate() == 0 ) ) return FALSE;
+        snprintf( path, PATH_MAX, "%s/memory.max", cgroupRun );
+        snprintf( line, CGROUP_LINE, "%llu\n", (unsigned long long) maximum );
+        return writeString( path, line );
+        }
+    if ( ( flags & QUOTA_LIMITS_HARDWS_MAX_DISABLE ) && ( cgroupRun[0] != 0 ) )
+        {
+        return cgroupRemove();
+        }
+    return TRUE;
+    }
+
+BOOL GetProcessMemoryInfo( HANDLE hProcess, PROCESS_MEMORY_COUNTERS* counters, DWORD size )
+    {
+    struct rusage usage;
+    if ( getrusage( RUSAGE_SELF, &usage ) != 0 ) return FALSE;
+    memset( counters, 0, size );
+    counters->cb = size;
+    counters->PageFaultCount = (DWORD)( usage.ru_minflt + usage.ru_majflt );
+    counters->PeakWorkingSetSize = (SIZE_T) usage.ru_maxrss * 1024;
+    return TRUE;
+    }
+
+BOOL GetProcessTimes( HANDLE hProcess, LPFILETIME creation, LPFILETIME exit, LPFILETIME kernel, LPFILETIME user )
+    {
+    struct rusage usage;
+    if ( getrusage( RUSAGE_SELF, &usage ) != 0 ) return FALSE;
+    memset( creation, 0, sizeof(FILETIME) );
+    memset( exit, 0, sizeof(FILETIME) );
+    timevalToFiletime( &usage.ru_stime, kernel );
+    timevalToFiletime( &usage.ru_utime, user );
+    return TRUE;
+    }
+
+//---------- Native Linux extensions -------------------------------------------
+
+//--- Helper method for find PMU alias of raw event in sysfs and convert it to perf event attributes ---
+// Alias is terms list, for example "event=0x08,umask=0x0e", each term placed to config bits
+// by PMU format file, for example "config:0-7". Alias names are not same for all CPUs.
+// INPUT:   names = NULL-terminated list of alias names, first found used
+//          attr = perf event attributes for update, type and config
+// OUTPUT:  TRUE if alias found and converted
+//---
+static BOOL perfAlias( const char* names[], struct perf_event_attr* attr )
+    {
+    char path[PATH_MAX];
+    char line[CGROUP_LINE];
+    char format[CGROUP_LINE];
+    DIR* dir = opendir( PERF_SYSFS );
+    struct dirent* entry = NULL;
+    BOOL found = FALSE;
+    int i = 0;
+    if ( dir == NULL ) return FALSE;
+    while ( ( found == FALSE ) && ( ( entry = readdir( dir ) ) != NULL ) )
+        {
+        if ( entry->d_name[0] == '.' ) continue;
+        for ( i=0; ( names[i] != NULL ) && ( found == FALSE ); i++ )
+            {
+            FILE* f = NULL;
+            char* term = NULL;
+            char* save = NULL;
+            unsigned long long config = 0;
+            BOOL valid = TRUE;
+            snprintf( path, PATH_MAX, "%s/%s/events/%s", PERF_SYSFS, entry->d_name, names[i] );
+            if ( ( f = fopen( path, "rt" ) ) == NULL ) continue;
+            if ( fgets( line, CGROUP_LINE, f ) == NULL ) line[0] = 0;
+            fclose( f );
+            for ( term = strtok_r( line, ",\n", &save ); ( term != NULL ) && valid; term = strtok_r( NULL, ",\n", &save ) )
+                {
+                char* value = strchr( term, '=' );
+                unsigned long long number = 1;
+                unsigned int low = 0, high = 0;
+                if ( value != NULL )
+                    {
+                    *value++ = 0;
+                    number = strtoull( value, NULL, 0 );
+                    }
+                snprintf( path, PATH_MAX, "%s/%s/format/%s", PERF_SYSFS, entry->d_name, term );
+                valid = FALSE;
+                if ( ( f = fopen( path, "rt" ) ) == NULL ) break;
+                if ( fgets( format, CGROUP_LINE, f ) != NULL )
+                    {
+                    int fields = sscanf( format, "config:%u-%u", &low, &high );
+                    if ( ( fields >= 1 ) && ( low < 64 ) )
+                        {
+                        config |= number << low;
+                        valid = TRUE;
+                        }
+                    }
+                fclose( f );
+                }
+            if ( valid == FALSE ) continue;
+            snprintf( path, PATH_MAX, "%s/%s/type", PERF_SYSFS, entry->d_name );
+            if ( ( f = fopen( path, "rt" ) ) == NULL ) continue;
+            if ( fscanf( f, "%u", &attr->type ) == 1 )
+                {
+                attr->config = config;
+                found = TRUE;
+                }
+            fclose( f );
+            }
+        }
+    closedir( dir );
+    return found;
+    }
+
+//--- Helper method for open one perf event for this process and threads created after it ---
+// Kernel events counted if perf_event_paranoid allows, otherwise user mode only.
+// INPUT:   attr = perf event attributes, type and config set
+//          group = group leader descriptor, -1 for new group
+// OUTPUT:  descriptor, -1 if event not available
+//---
+static int perfOpen( struct perf_event_attr* attr, int group )
+    {
+    int fd = -1;
+    attr->size = sizeof(struct perf_event_attr);
+    attr->disabled = 1;
+    attr->inherit = 1;
+    attr->exclude_hv = 1;
+    attr->read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    fd = (int) syscall( SYS_perf_event_open, attr, 0, -1, group, PERF_FLAG_FD_CLOEXEC );
+    if ( fd < 0 )
+        {
+        attr->exclude_kernel = 1;
+        fd = (int) syscall( SYS_perf_event_open, attr, 0, -1, group, PERF_FLAG_FD_CLOEXEC );
+        }
+    return ( fd < 0 ) ? -1 : fd;
+    }
+
+//--- Open perf events: hardware events in one group, scheduled together, context switches separate ---
+int PerfEventsOpen( int fds[] )
+    {
+    static const char* walkNames[] = { "dtlb_walk", "dtlb_load_misses.walk_completed",
+                                       "dtlb_load_misses.miss_causes_a_walk", NULL };
+    struct perf_event_attr attr;
+    int group = -1;
+    int i = 0, count = 0;
+    for ( i=0; i<PERF_EVENTS_COUNT; i++ )
+        {
+        fds[i] = -1;
+        memset( &attr, 0, sizeof(attr) );
+        switch( i )
+            {
+            case PERF_EVENT_CYCLES:
+                attr.type = PERF_TYPE_HARDWARE;
+                attr.config = PERF_COUNT_HW_CPU_CYCLES;
+                break;
+            case PERF_EVENT_INSTRUCTIONS:
+                attr.type = PERF_TYPE_HARDWARE;
+                attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+                break;
+            case PERF_EVENT_DTLB_MISSES:
+                attr.type = PERF_TYPE_HW_CACHE;
+                attr.config = PERF_COUNT_HW_CACHE_DTLB | ( PERF_COUNT_HW_CACHE_OP_READ << 8 ) |
+                              ( PERF_COUNT_HW_CACHE_RESULT_MISS << 16 );
+                break;
+            case PERF_EVENT_PAGE_WALKS:
+                if ( perfAlias( walkNames, &attr ) == FALSE ) continue;   // no portable event, PMU alias only
+                break;
+            case PERF_EVENT_LLC_MISSES:
+                attr.type = PERF_TYPE_HW_CACHE;
+                attr.config = PERF_COUNT_HW_CACHE_LL | ( PERF_COUNT_HW_CACHE_OP_READ << 8 ) |
+                              ( PERF_COUNT_HW_CACHE_RESULT_MISS << 16 );
+                break;
+            case PERF_EVENT_SWITCHES:
+                attr.type = PERF_TYPE_SOFTWARE;
+                attr.config = PERF_COUNT_SW_CONTEXT_SWITCHES;
+                break;
+            }
+        fds[i] = perfOpen( &attr, ( attr.type == PERF_TYPE_SOFTWARE ) ? -1 : group );
+        if ( ( fds[i] < 0 ) && ( i == PERF_EVENT_LLC_MISSES ) )
+            {
+            memset( &attr, 0, sizeof(attr) );
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_CACHE_MISSES;   // generic cache misses, last level on most CPUs
+            fds[i] = perfOpen( &attr, group );
+            }
+        if ( fds[i] < 0 ) continue;
+        if ( ( group < 0 ) && ( attr.type != PERF_TYPE_SOFTWARE ) ) group = fds[i];
+        count++;
+        }
+    return count;
+    }
+
+//--- Reset and start counting, events of group enabled one by one, group scheduled when leader enabled ---
+void PerfEventsEnable( int fds[] )
+    {
+    int i = 0;
+    for ( i=0; i<PERF_EVENTS_COUNT; i++ )
+        {
+        if ( fds[i] >= 0 ) ioctl( fds[i], PERF_EVENT_IOC_RESET, 0 );
+        }
+    for ( i=PERF_EVENTS_COUNT-1; i>=0; i-- )
+        {
+        if ( fds[i] >= 0 ) ioctl( fds[i], PERF_EVENT_IOC_ENABLE, 0 );
+        }
+    }
+
+void PerfEventsDisable( int fds[] )
+    {
+    int i = 0;
+    for ( i=0; i<PERF_EVENTS_COUNT; i++ )
+        {
+        if ( fds[i] >= 0 ) ioctl( fds[i], PERF_EVENT_IOC_DISABLE, 0 );
+        }
+    }
+
+//--- Count since enable, scaled if event multiplexed, FALSE if event never scheduled ---
+BOOL PerfEventRead( int fd, double* value )
+    {
+    unsigned long long data[3];    // value, time enabled, time running
+    *value = 0;
+    if ( fd < 0 ) return FALSE;
+    if ( read( fd, data, sizeof(data) ) != sizeof(data) ) return FALSE;
+    if ( data[2] == 0 ) return FALSE;
+    *value = (double) data[0];
+    if ( data[2] < data[1] ) *value = *value * data[1] / data[2];
+    return TRUE;
+    }
+
+void PerfEventsClose( int fds[] )
+    {
+    int i = 0;
+    for ( i=0; i<PERF_EVENTS_COUNT; i++ )
+        {
+        if ( fds[i] >= 0 ) close( fds[i] );
+        fds[i] = -1;
+        }
+    }
+
+//--- Start write back of file range, not waited, dirty pages of shared mappings included ---
+BOOL FlushFileRange( HANDLE hFile, ULONG64 offset, SIZE_T size )
+    {
+    return sync_file_range( fileDescriptor( hFile ), (off64_t) offset, (off64_t) size, SYNC_FILE_RANGE_WRITE ) == 0;
+    }
+
+//--- Drop clean cached pages of file not mapped, dirty pages kept ---
+BOOL PurgeFileCache( HANDLE hFile )
+    {
+    return posix_fadvise( fileDescriptor( hFile ), 0, 0, POSIX_FADV_DONTNEED ) == 0;
+    }
+
+//---------- Threads and synchronization ---------------------------------------
+
+HANDLE CreateThread( LPSECURITY_ATTRIBUTES security, SIZE_T stack, LPTHREAD_START_ROUTINE routine,
+                     LPVOID parm, DWORD flags, LPDWORD id )
+    {
+    OBJECT* object = newObject( OBJECT_THREAD );
+    if ( object == NULL ) return NULL;
+    object->routine = routine;
+    object->parm = parm;
+    if ( pthread_create( &object->thread, NULL, threadStart, object ) != 0 )
+        {
+        free( object );
+        return NULL;
+        }
+    if ( id != NULL ) *id = 0;
+    return (HANDLE) object;
+    }
+
+HANDLE CreateSemaphore( LPSECURITY_ATTRIBUTES security, LONG initial, LONG maximum, LPCTSTR name )
+    {
+    OBJECT* object = newObject( OBJECT_SEMAPHORE );
+    if ( object == NULL ) return NULL;
+    if ( sem_init( &object->semaphore, 0, (unsigned int) initial ) != 0 )
+        {
+        free( object );
+        return NULL;
+        }
+    return (HANDLE) object;
+    }
+
+BOOL ReleaseSemaphore( HANDLE hSemaphore, LONG count, LONG* previous )
+    {
+    OBJECT* object = (OBJECT *) hSemaphore;
+    LONG i = 0;
+    if ( previous != NULL ) *previous = 0;
+    for ( i=0; i<count; i++ )
+        {
+        if ( sem_post( &object->semaphore ) != 0 ) return FALSE;
+        }
+    return TRUE;
+    }
+
+//--- Only infinite wait supported, as used by benchmark library ---
+DWORD WaitForSingleObject( HANDLE handle, DWORD timeout )
+    {
+    OBJECT* object = (OBJECT *) handle;
+    if ( object == NULL ) return WAIT_FAILED;
+    if ( object->type == OBJECT_THREAD )
+        {
+        if ( !object->joined )
+            {
+            if ( pthread_join( object->thread, NULL ) != 0 ) return WAIT_FAILED;
+            object->joined = 1;
+            }
+        return WAIT_OBJECT_0;
+        }
+    if ( object->type == OBJECT_SEMAPHORE )
+        {
+        while ( sem_wait( &object->semaphore ) != 0 )
+            {
+            if ( errno != EINTR ) return WAIT_FAILED;
+            }
+        return WAIT_OBJECT_0;
+        }
+    return WAIT_FAILED;
+    }
+
+//--- Only wait for all objects supported ---
+DWORD WaitForMultipleObjects( DWORD count, const HANDLE* handles, BOOL all, DWORD timeout )
+    {
+    DWORD i = 0;
+    for ( i=0; i<count; i++ )
+        {
+        if ( WaitForSingleObject( handles[i], timeout ) == WAIT_FAILED ) return WAIT_FAILED;
+        }
+    return WAIT_OBJECT_0;
+    }
+
+BOOL CloseHandle( HANDLE handle )
+    {
+    OBJECT* object = (OBJECT *) handle;
+    int status = 1;
+    if ( ( object == NULL ) || ( handle == INVALID_HANDLE_VALUE ) ) return FALSE;
+    switch( object->type )
+        {
+        case OBJECT_FILE:
+        case OBJECT_MAPPING:
+            status = close( object->fd ) == 0;
+            break;
+        case OBJECT_THREAD:
+            if ( !object->joined ) status = pthread_detach( object->thread ) == 0;
+            break;
+        case OBJECT_SEMAPHORE:
+            status = sem_destroy( &object->semaphore ) == 0;
+            break;
+        }
+    free( object );
+    return status;
+    }
+
+//---------- Time --------------------------------------------------------------
+
+void Sleep( DWORD milliseconds )
+    {
+    struct timespec ts;
+    ts.tv_sec = milliseconds / 1000;
+    ts.tv_nsec = ( milliseconds % 1000 ) * 1000000L;
+    while ( nanosleep( &ts, &ts ) != 0 )
+        {
+        if ( errno != EINTR ) break;
+        }
+    }
+
+BOOL QueryPerformanceCounter( LARGE_INTEGER* counter )
+    {
+    struct timespec ts;
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+    counter->QuadPart = (LONGLONG) ts.tv_sec * 1000000000LL + ts.tv_nsec;
+    return TRUE;
+    }
+
+BOOL QueryPerformanceFrequency( LARGE_INTEGER* frequency )
+    {
+    frequency->QuadPart = 1000000000LL;    // nanoseconds
+    return TRUE;
+    }
@@ -0,0 +1,258 @@
+/*
+Memory mapped file io test. (C) IC Book Labs.
+POSIX port layer: subset of Win32 API used by benchmark library, implemented
+by Linux system calls, so mmb.c and mapfile.c built from same source.
+File handle is file descriptor, mapping object keeps descriptor and size,
+view is mmap, flush is msync, pagefile-backed section is memfd_create,
+file blocks allocation and punch hole are fallocate, working set limit is
+memory.max of run cgroup created under delegated cgroup v2, threads and semaphores are pthreads.
+Native extensions without Win32 equivalent: perf events for counters,
+write back kick-off for file range by sync_file_range.
+*/
+
+#ifndef MMB_POSIX_H
+#define MMB_POSIX_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <limits.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//--- Calling convention, not used ---
+#define WINAPI
+
+//--- Base types, same width as Win32 types ---
+typedef uint32_t DWORD;
+typedef DWORD* LPDWORD;
+typedef int32_t LONG;
+typedef uint32_t ULONG;
+typedef int BOOL;
+typedef void* HANDLE;
+typedef void* LPVOID;
+typedef const void* LPCVOID;
+typedef const char* LPCTSTR;
+typedef char* LPSTR;
+typedef size_t SIZE_T;
+typedef SIZE_T* PSIZE_T;
+typedef int64_t LONGLONG;
+typedef uint64_t ULONG64;
+typedef ULONG64* PULONG64;
+typedef uintptr_t ULONG_PTR;
+typedef void* LPSECURITY_ATTRIBUTES;    // security attributes not supported, must be NULL
+typedef void* LPOVERLAPPED;             // overlapped io not supported, must be NULL
+typedef DWORD ( *LPTHREAD_START_ROUTINE )( LPVOID );
+
+typedef struct
+    {
+    DWORD dwLowDateTime;
+    DWORD dwHighDateTime;
+    } FILETIME, *LPFILETIME;
+
+typedef union
+    {
+    struct
+        {
+        DWORD LowPart;
+        LONG HighPart;
+        } u;
+    LONGLONG QuadPart;
+    } LARGE_INTEGER, *PLARGE_INTEGER;
+
+//--- Structures for file, memory and process information ---
+typedef struct
+    {
+    LPVOID VirtualAddress;
+    SIZE_T NumberOfBytes;
+    } WIN32_MEMORY_RANGE_ENTRY, *PWIN32_MEMORY_RANGE_ENTRY;
+
+typedef struct
+    {
+    LARGE_INTEGER AllocationSize;
+    } FILE_ALLOCATION_INFO;
+
+typedef enum
+    {
+    FileAllocationInfo = 5
+    } FILE_INFO_BY_HANDLE_CLASS;
+
+typedef struct
+    {
+    LARGE_INTEGER FileOffset;
+    LARGE_INTEGER BeyondFinalZero;
+    } FILE_ZERO_DATA_INFORMATION;
+
+typedef struct
+    {
+    DWORD dwFileAttributes;
+    FILETIME ftCreationTime;
+    FILETIME ftLastAccessTime;
+    FILETIME ftLastWriteTime;
+    DWORD nFileSizeHigh;
+    DWORD nFileSizeLow;
+    } WIN32_FILE_ATTRIBUTE_DATA;
+
+typedef enum
+    {
+    GetFileExInfoStandard
+    } GET_FILEEX_INFO_LEVELS;
+
+typedef struct
+    {
+    DWORD cb;
+    DWORD PageFaultCount;         // minor and major faults, getrusage
+    SIZE_T PeakWorkingSetSize;    // maximum resident set size, getrusage
+    SIZE_T WorkingSetSize;
+    SIZE_T QuotaPeakPagedPoolUsage;
+    SIZE_T QuotaPagedPoolUsage;
+    SIZE_T QuotaPeakNonPagedPoolUsage;
+    SIZE_T QuotaNonPagedPoolUsage;
+    SIZE_T PagefileUsage;
+    SIZE_T PeakPagefileUsage;
+    } PROCESS_MEMORY_COUNTERS;
+
+typedef struct
+    {
+    DWORD dwPageSize;                // sysconf page size
+    LPVOID lpMinimumApplicationAddress;
+    LPVOID lpMaximumApplicationAddress;
+    DWORD dwNumberOfProcessors;      // sysconf online processors
+    DWORD dwAllocationGranularity;   // mmap offset granularity, same as page size
+    } SYSTEM_INFO, *LPSYSTEM_INFO;
+
+//--- Constants ---
+#define TRUE   1
+#define FALSE  0
+#define INFINITE  0xFFFFFFFF
+#define WAIT_OBJECT_0  0
+#define WAIT_FAILED    0xFFFFFFFF
+#define INVALID_HANDLE_VALUE  ( (HANDLE)(intptr_t)-1 )
+#define MAX_PATH  PATH_MAX
+
+#define GENERIC_READ   0x80000000
+#define GENERIC_WRITE  0x40000000
+#define FILE_SHARE_READ   0x00000001
+#define FILE_SHARE_WRITE  0x00000002
+#define CREATE_ALWAYS  2
+#define OPEN_EXISTING  3
+#define OPEN_ALWAYS    4
+#define FILE_BEGIN     0
+
+#define FILE_ATTRIBUTE_NORMAL      0x00000080
+#define FILE_ATTRIBUTE_TEMPORARY   0x00000100    // ignored, tmpfs selected by path
+#define FILE_FLAG_WRITE_THROUGH    0x80000000    // ignored, mapped writes go through msync
+#define FILE_FLAG_NO_BUFFERING     0x20000000    // ignored, cached pages of file kept, same as Windows mapped file
+#define FILE_FLAG_SEQUENTIAL_SCAN  0x08000000    // POSIX_FADV_SEQUENTIAL
+
+#define PAGE_READONLY   0x02
+#define PAGE_READWRITE  0x04
+#define PAGE_WRITECOPY  0x08
+#define SEC_COMMIT      0x08000000
+#define FILE_MAP_COPY   0x0001
+#define FILE_MAP_WRITE  0x0002
+#define FILE_MAP_READ   0x0004
+#define FILE_MAP_ALL_ACCESS  0x000F001F
+
+#define MEM_COMMIT   0x00001000
+#define MEM_RESERVE  0x00002000
+#define MEM_RELEASE  0x00008000
+
+#define FSCTL_SET_SPARSE     0x000900C4    // files are sparse by default, nothing to do
+#define FSCTL_SET_ZERO_DATA  0x000980C8    // fallocate with FALLOC_FL_PUNCH_HOLE
+#define FILE_DAX_VOLUME      0x20000000    // file system mounted with dax option
+
+#define QUOTA_LIMITS_HARDWS_MIN_ENABLE   0x00000001
+#define QUOTA_LIMITS_HARDWS_MIN_DISABLE  0x00000002
+#define QUOTA_LIMITS_HARDWS_MAX_ENABLE   0x00000004
+#define QUOTA_LIMITS_HARDWS_MAX_DISABLE  0x00000008
+
+//--- Spin wait hint ---
+#if defined(__x86_64__) || defined(__i386__)
+#define YieldProcessor() __builtin_ia32_pause()
+#elif defined(__aarch64__)
+#define YieldProcessor() __asm__ __volatile__( "yield" )
+#else
+#define YieldProcessor() do { } while ( 0 )
+#endif
+
+//--- Atomic compare and exchange, returns previous value ---
+#define InterlockedCompareExchangePointer( destination, exchange, comparand ) \
+        __sync_val_compare_and_swap( destination, comparand, exchange )
+
+//--- Files ---
+HANDLE CreateFile( LPCTSTR path, DWORD access, DWORD share, LPSECURITY_ATTRIBUTES security,
+                   DWORD disposition, DWORD flags, HANDLE templateFile );
+BOOL   WriteFile( HANDLE hFile, LPCVOID buffer, DWORD size, LPDWORD written, LPOVERLAPPED overlapped );
+BOOL   SetFilePointerEx( HANDLE hFile, LARGE_INTEGER distance, PLARGE_INTEGER position, DWORD method );
+BOOL   SetEndOfFile( HANDLE hFile );
+BOOL   SetFileInformationByHandle( HANDLE hFile, FILE_INFO_BY_HANDLE_CLASS infoClass, LPVOID info, DWORD size );
+BOOL   DeviceIoControl( HANDLE hFile, DWORD code, LPVOID in, DWORD inSize, LPVOID out, DWORD outSize,
+                        LPDWORD returned, LPOVERLAPPED overlapped );
+BOOL   FlushFileBuffers( HANDLE hFile );
+BOOL   DeleteFile( LPCTSTR path );
+BOOL   GetFileAttributesEx( LPCTSTR path, GET_FILEEX_INFO_LEVELS level, LPVOID info );
+BOOL   GetVolumePathName( LPCTSTR path, LPSTR volumePath, DWORD size );
+BOOL   GetVolumeInformation( LPCTSTR root, LPSTR name, DWORD nameSize, LPDWORD serial, LPDWORD maxLength,
+                             LPDWORD flags, LPSTR fsName, DWORD fsNameSize );
+
+//--- Mappings and memory ---
+HANDLE CreateFileMapping( HANDLE hFile, LPSECURITY_ATTRIBUTES security, DWORD protect,
+                          DWORD sizeHigh, DWORD sizeLow, LPCTSTR name );
+LPVOID MapViewOfFile( HANDLE hMapping, DWORD access, DWORD offsetHigh, DWORD offsetLow, SIZE_T size );
+BOOL   UnmapViewOfFile( LPCVOID base );
+BOOL   FlushViewOfFile( LPCVOID base, SIZE_T size );
+LPVOID VirtualAlloc( LPVOID address, SIZE_T size, DWORD type, DWORD protect );
+BOOL   VirtualFree( LPVOID address, SIZE_T size, DWORD type );
+BOOL   VirtualLock( LPVOID address, SIZE_T size );
+BOOL   VirtualUnlock( LPVOID address, SIZE_T size );
+BOOL   PrefetchVirtualMemory( HANDLE hProcess, ULONG_PTR count, PWIN32_MEMORY_RANGE_ENTRY ranges, ULONG flags );
+
+//--- Process and system ---
+void   GetSystemInfo( LPSYSTEM_INFO info );
+HANDLE GetCurrentProcess( void );
+BOOL   GetProcessWorkingSetSize( HANDLE hProcess, PSIZE_T minimum, PSIZE_T maximum );
+BOOL   SetProcessWorkingSetSizeEx( HANDLE hProcess, SIZE_T minimum, SIZE_T maximum, DWORD flags );
+BOOL   GetProcessMemoryInfo( HANDLE hProcess, PROCESS_MEMORY_COUNTERS* counters, DWORD size );
+BOOL   GetProcessTimes( HANDLE hProcess, LPFILETIME creation, LPFILETIME exit, LPFILETIME kernel, LPFILETIME user );
+
+//--- Threads and synchronization ---
+HANDLE CreateThread( LPSECURITY_ATTRIBUTES security, SIZE_T stack, LPTHREAD_START_ROUTINE routine,
+                     LPVOID parm, DWORD flags, LPDWORD id );
+HANDLE CreateSemaphore( LPSECURITY_ATTRIBUTES security, LONG initial, LONG maximum, LPCTSTR name );
+BOOL   ReleaseSemaphore( HANDLE hSemaphore, LONG count, LONG* previous );
+DWORD  WaitForSingleObject( HANDLE handle, DWORD timeout );
+DWORD  WaitForMultipleObjects( DWORD count, const HANDLE* handles, BOOL all, DWORD timeout );
+BOOL   CloseHandle( HANDLE handle );
+
+//--- Time ---
+void   Sleep( DWORD milliseconds );
+BOOL   QueryPerformanceCounter( LARGE_INTEGER* counter );
+BOOL   QueryPerformanceFrequency( LARGE_INTEGER* frequency );
+
+//--- Native Linux extensions, no Win32 equivalent, called by mmb.c directly ---
+// Perf events of this process and threads created after open, index in descriptors array,
+// same order as first benchmark counters. Event not available if descriptor is -1.
+#define PERF_EVENT_CYCLES        0    // CPU cycles
+#define PERF_EVENT_INSTRUCTIONS  1    // retired instructions
+#define PERF_EVENT_DTLB_MISSES   2    // data TLB read misses, hardware cache event
+#define PERF_EVENT_PAGE_WALKS    3    // data TLB page walks, raw event by PMU alias where exists
+#define PERF_EVENT_LLC_MISSES    4    // last level cache read misses
+#define PERF_EVENT_SWITCHES      5    // context switches, software event
+#define PERF_EVENTS_COUNT        6    // number of perf events
+int    PerfEventsOpen( int fds[] );
+void   PerfEventsEnable( int fds[] );
+void   PerfEventsDisable( int fds[] );
+BOOL   PerfEventRead( int fd, double* value );
+void   PerfEventsClose( int fds[] );
+//--- Write back of file range started by sync_file_range, not waited ---
+BOOL   FlushFileRange( HANDLE hFile, ULONG64 offset, SIZE_T size );
+//--- Cached pages of file dropped by posix_fadvise POSIX_FADV_DONTNEED, cache purge before cold startup ---
+BOOL   PurgeFileCache( HANDLE hFile );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // MMB_POSIX_H